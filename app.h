@@ -14,8 +14,17 @@ struct Context
   SCVGLCtx      GLContext;
   SCVRect       Window;
   SCVTimer      Timer;
-  u32           scvTextureID;
-  SCVFont       *font;
+  SCVHandle     logo;     // atlas entry, pinned
+  SCVHandle     font;
+  SCVIO         io;
+  SCVArena      loadArena;
+  SCVIORequest  logoLoad;
+  SCVIORequest  fontLoad;
+  u32           loadsPending;
+  i32           ioFd;     // platform loop watches it when >= 0
+  u32           dirty;    // frame has to be drawn
+  SCVIONotifyProc Wake;   // wakes platform loop, any thread
+  void          *WakeData;
 };
 
 Context GlobalContext = {0};
@@ -33,6 +42,10 @@ InitContext(Context* ctx, SCVRect window, f32 scaleFactor)
   scvAssert(ctx);
   scvClear((void *)ctx, sizeof(Context));
   scvInitTimer(&ctx->Timer);
+  scvTimerTic(&ctx->Timer);
+  scvLogStart(&((SCVLogDesc){
+    .overflow = SCV_LOG_OVERFLOW_COUNT,
+  }));
 
   scvArenaInit(&ctx->arena, &error);
   scvAssert(error.tag == 0);
@@ -43,21 +56,51 @@ InitContext(Context* ctx, SCVRect window, f32 scaleFactor)
   }));
 }
 
+// anything which changes what's on screen calls it, platform loop sleeps
+// until Wake. Can be called from any thread.
 void
-AppInit(Context* ctx, SCVRect window, f32 scaleFactor)
+AppInvalidate(Context* ctx)
+{
+  SCVIONotifyProc wake;
+
+  if (scvAtomicExchange(&ctx->dirty, 1) == 0) {
+    wake = scvAtomicLoad(&ctx->Wake);
+    if (wake) {
+      wake(scvAtomicLoad(&ctx->WakeData));
+    }
+  }
+}
+
+bool
+AppNeedsUpdate(Context* ctx)
+{
+  return scvAtomicLoad(&ctx->dirty) != 0;
+}
+
+// set by platform after AppInit
+void
+AppSetWake(Context* ctx, SCVIONotifyProc wake, void *data)
+{
+  scvAtomicStore(&ctx->WakeData, data);
+  scvAtomicStore(&ctx->Wake, wake);
+}
+
+// io thread finished something, next frame polls it
+void
+AppIONotify(void *data)
+{
+  AppInvalidate(data);
+}
+
+void
+AppLoadLogo(Context* ctx, SCVString data)
 {
   int      comp, width, height;
-  SCVSlice scvImageContent = {0};
-  SCVError error = {0};
   SCVImage scvLogoImage = {0};
-  InitContext(ctx, window, scaleFactor);
-
-  scvImageContent = scvLoadFile(scvUnsafeCString("scv.jpg"), &error);
-  scvAssert(error.tag == 0);
 
   scvLogoImage.data = stbi_load_from_memory(
-      scvImageContent.base,
-      scvImageContent.len,
+      data.base,
+      (int)data.len,
       &width,
       &height,
       &comp,
@@ -74,60 +117,189 @@ AppInit(Context* ctx, SCVRect window, f32 scaleFactor)
   else if (comp == 3) scvLogoImage.pixelformat = SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8;
   else if (comp == 4) scvLogoImage.pixelformat = SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
 
-  ctx->scvTextureID = scvGLLoadTexture(scvLogoImage);
+  // pinned, pixels are freed below and couldn't be added again
+  ctx->logo = scvAtlasAdd(&ctx->GLContext, scvLogoImage, SCV_ATLAS_PINNED);
+  stbi_image_free(scvLogoImage.data);
+}
 
-  ctx->font = scvFontInit(&ctx->GLContext, &ctx->arena, &((SCVFontDesc){
-    .fontsize = 36.0,
-    .fontpath = scvUnsafeCString("./assets/3270-Regular.ttf")
-  }));
+// frames are drawn without assets until they arrive, loadArena is reset once
+// all of them are turned into textures/fonts
+void
+AppPollLoads(Context* ctx)
+{
+  SCVIORequest *done[4];
+  SCVIORequest *req;
+  u64 i, n;
 
-  int maxTexSize;
-  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
-  scvPrint("MAXTEXSIZE");
-  scvPrintU64((u64)maxTexSize);
-  
-  stbi_image_free(scvLogoImage.data);
-  scvUnloadFile(scvImageContent);
+  if (ctx->loadsPending == 0) {
+    return;
+  }
+
+  n = scvIOPoll(&ctx->io, done, 4);
+  if (n == 4) {
+    // maybe more are done, come back next frame
+    AppInvalidate(ctx);
+  }
+  for (i = 0; i < n; ++i) {
+    req = done[i];
+    ctx->loadsPending--;
+    if (req->status == SCV_IO_FAILED) {
+      scvFatalError("can't load asset", &req->err);
+    }
+
+    if (req == &ctx->logoLoad) {
+      AppLoadLogo(ctx, req->data);
+    } else if (req == &ctx->fontLoad) {
+      ctx->font = scvFontInit(&ctx->GLContext, &ctx->arena, &((SCVFontDesc){
+        .fontsize = 36.0,
+        .fontdata = req->data
+      }));
+      if (ctx->font == SCV_HANDLE_NIL) {
+        scvFatalError("can't read font", nil);
+      }
+    }
+  }
+
+  if (ctx->loadsPending == 0) {
+    scvArenaReset(&ctx->loadArena);
+#ifdef SCV_MEM_STATS
+    AppPrintMemStats(ctx);
+#endif
+  }
 }
 
 void
+AppInit(Context* ctx, SCVRect window, f32 scaleFactor)
+{
+  SCVError error = {0};
+  InitContext(ctx, window, scaleFactor);
+
+  scvArenaInitReserve(&ctx->loadArena, 1ull << 32, &error);
+  scvAssert(error.tag == 0);
+  ctx->loadArena.tag = SCV_MEM_TAG_IMAGES;
+
+  scvIOInit(&ctx->io, nil);
+  ctx->ioFd = scvIOSetNotify(&ctx->io, AppIONotify, ctx);
+  scvIOLoad(&ctx->io, &ctx->logoLoad, scvUnsafeCString("scv.jpg"), &ctx->loadArena);
+  scvIOLoad(&ctx->io, &ctx->fontLoad, scvUnsafeCString("./assets/3270-Regular.ttf"), &ctx->loadArena);
+  scvIOSubmit(&ctx->io);
+  ctx->loadsPending = 2;
+  ctx->dirty = 1;
+}
+
+// on demand dump of memory footprint, per tag numbers need SCV_MEM_STATS
+void
+AppPrintMemStats(Context* ctx)
+{
+  u64 i;
+  SCVMemStats stats;
+  SCVMemStats total = {0};
+
+  stats = scvArenaStats(&ctx->arena);
+  scvPrintMemStats("arena", &stats);
+  scvMemStatsAdd(&total, &stats);
+
+  stats = scvSlabPoolStats(&ctx->GLContext.Textures);
+  scvPrintMemStats("textures", &stats);
+  scvMemStatsAdd(&total, &stats);
+
+  stats = scvSlabPoolStats(&ctx->GLContext.Fonts);
+  scvPrintMemStats("fonts", &stats);
+  scvMemStatsAdd(&total, &stats);
+
+  for (i = 0; i < SCV_SCRATCH_COUNT; ++i) {
+    stats = scvArenaStats(&scvScratchArenas[i]);
+    scvPrintMemStats("scratch", &stats);
+    scvMemStatsAdd(&total, &stats);
+  }
+
+  scvPrintMemStats("total", &total);
+}
+
+// every few seconds prints per zone stats of frames since last report
+void
+AppReportProfile(Context* ctx)
+{
+  u8 buf[4096];
+  SCVWriter w;
+  SCVSlice stats;
+  SCVArenaTemp scratch;
+
+  if (scvTimerToc(&ctx->Timer, SCV_MS) < 5000) {
+    return;
+  }
+
+  scratch = scvScratchBegin(nil, 0);
+  stats = scvProfileAggregate(scratch.arena);
+  scvWriterFd(&w, 2, scvUnsafeSlice(buf, sizeof(buf)));
+  scvProfileWriteStats(&w, stats);
+  scvWriterFlush(&w);
+  scvScratchEnd(scratch);
+
+  scvProfileReset();
+  scvTimerTic(&ctx->Timer);
+}
+
+// returns false without drawing anything when nothing changed
+bool
 AppUpdate(Context* ctx)
 {
   SCVGLCtx *glctx; 
+  SCVFont  *font;
+
+  if (scvAtomicExchange(&ctx->dirty, 0) == 0) {
+    return false;
+  }
+
+  scvZoneBegin("AppUpdate");
   glctx = &ctx->GLContext;
+  scvScratchReset();
+  AppPollLoads(ctx);
+  font  = scvGetFont(glctx, ctx->font);
   glClearColor(1.0f, 1.0f, 0.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT);
 
   scvGLBegin(glctx);
 
-  scvGLDrawImage(
-      glctx,
-      (SCVRect){
-        .origin = { 256.0f, 256.0f },
-        .size = { 256.0f, 256.0f }
-      },
-      (SCVColor){ 255, 255, 255, 255 },
-      ctx->scvTextureID
-  );
+  if (ctx->logo) {
+    scvGLDrawAtlasImage(
+        glctx,
+        (SCVRect){
+          .origin = { 256.0f, 256.0f },
+          .size = { 256.0f, 256.0f }
+        },
+        (SCVColor){ 255, 255, 255, 255 },
+        ctx->logo
+    );
+  }
 
   SCVString str = scvUnsafeCString("абвгдеёжзиклмнопрст");
 
-  SCVRect rect = {0};
-  
-  rect.origin.x = 10.0f;
-  rect.size = scvMeasureText(ctx->font, str);
+  if (font) {
+    SCVRect rect = {0};
+    
+    rect.origin.x = 10.0f;
+    rect.size = scvMeasureText(font, str);
 
-  //scvGLDrawRect(glctx, rect, (SCVColor){ 255, 255, 0, 255});
+    //scvGLDrawRect(glctx, rect, (SCVColor){ 255, 255, 0, 255});
 
-  scvDrawText(
-      glctx, 
-      (SCVColor){ 255, 0, 255, 255 },
-      ctx->font,
-      (SCVPoint){ 10.0f, 0.0f },
-      str
-  );
+    scvDrawText(
+        glctx, 
+        (SCVColor){ 255, 0, 255, 255 },
+        font,
+        (SCVPoint){ 10.0f, 0.0f },
+        str
+    );
+  }
 
   scvGLEnd(glctx);
+  scvZoneEnd();
+
+#ifdef SCV_PROFILE
+  AppReportProfile(ctx);
+#endif
+
+  return true;
 }
 
 #endif
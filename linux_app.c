@@ -0,0 +1,2269 @@
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+
+#ifdef SCV_GL_BENCH
+#include <stddef.h>
+#include <math.h>
+#include <assert.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glcorearb.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "external/stb_image.h"
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "external/stb_truetype.h"
+#endif
+
+#define SCV_PAGE_SIZE 4096
+
+#include "scv.h"
+
+#ifdef SCV_GL_BENCH
+#include "scv_geom.h"
+#include "scv_linalg.h"
+#include "scv_gl.h"
+#endif
+
+#define unused(a) (void)(a)
+
+// headless build of SCV core, no window layer on linux yet
+
+#define BENCH_ITERATIONS 1000000
+
+void
+BenchReport(char *name, u64 iterations, u64 ns)
+{
+  u8 linebuf[256];
+  u64 n = 0;
+  SCVSlice s = scvUnsafeSlice(linebuf, sizeof(linebuf));
+
+  n += scvSlicePutCString(scvSliceLeft(s, n), name);
+  n += scvSlicePutCString(scvSliceLeft(s, n), ": ");
+  n += scvSlicePutU64(scvSliceLeft(s, n), ns);
+  n += scvSlicePutCString(scvSliceLeft(s, n), " ns total, ");
+  n += scvSlicePutU64(scvSliceLeft(s, n), ns / iterations);
+  n += scvSlicePutCString(scvSliceLeft(s, n), " ns/op");
+
+  scvPrintString(scvString(scvSliceRight(s, n)));
+}
+
+void
+BenchTimer(void)
+{
+  SCVTimer timer = {0};
+  SCVTimer inner = {0};
+  u64 i, sink = 0;
+
+  scvInitTimer(&timer);
+  scvInitTimer(&inner);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < BENCH_ITERATIONS; ++i) {
+    scvTimerTic(&inner);
+    sink += scvTimerToc(&inner, SCV_NS);
+  }
+  BenchReport("timer tic/toc", BENCH_ITERATIONS, scvTimerToc(&timer, SCV_NS));
+  unused(sink);
+}
+
+// returns base of thread's scratch arena, it is unmapped once thread exits
+void*
+BenchScratchThread(void *arg)
+{
+  SCVArenaTemp temp = scvScratchBegin(nil, 0);
+  void *base = temp.arena->buf;
+
+  unused(arg);
+  scvAssert(scvArenaAlloc(temp.arena, 4096));
+  scvScratchEnd(temp);
+
+  return base;
+}
+
+void
+BenchArena(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVArenaTemp temp;
+  SCVMemStats stats;
+  SCVThread thread;
+  void *base;
+  u64 i;
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < BENCH_ITERATIONS; ++i) {
+    scvAssert(scvArenaAlloc(&arena, 64));
+  }
+  BenchReport("arena alloc 64b", BENCH_ITERATIONS, scvTimerToc(&timer, SCV_NS));
+
+  scvArenaReset(&arena);
+  scvTimerTic(&timer);
+  for (i = 0; i < BENCH_ITERATIONS; ++i) {
+    scvAssert(scvArenaAlloc(&arena, 64));
+  }
+  BenchReport("arena alloc 64b reused", BENCH_ITERATIONS, scvTimerToc(&timer, SCV_NS));
+
+  scvArenaReset(&arena);
+  scvTimerTic(&timer);
+  for (i = 0; i < BENCH_ITERATIONS; ++i) {
+    scvAssert(scvArenaAllocNoZero(&arena, 64));
+  }
+  BenchReport("arena alloc 64b no zero", BENCH_ITERATIONS, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < BENCH_ITERATIONS; ++i) {
+    temp = scvArenaTempBegin(&arena);
+    scvAssert(scvArenaAllocNoZero(&arena, 4096));
+    scvArenaTempEnd(temp);
+  }
+  BenchReport("arena temp begin/alloc/end", BENCH_ITERATIONS, scvTimerToc(&timer, SCV_NS));
+
+#ifdef SCV_MEM_STATS
+  // temp end rolls back counters too, so checkpoints don't look like growth
+  stats = scvArenaStats(&arena);
+  temp = scvArenaTempBegin(&arena);
+  scvAssert(scvArenaAlloc(&arena, 4096));
+  scvArenaTempEnd(temp);
+  scvAssert(scvArenaStats(&arena).tagBytes[arena.tag] == stats.tagBytes[arena.tag]);
+  scvAssert(scvArenaStats(&arena).allocCount == stats.allocCount);
+#endif
+
+  scvTimerTic(&timer);
+  for (i = 0; i < BENCH_ITERATIONS; ++i) {
+    temp = scvScratchBegin(nil, 0);
+    scvAssert(scvArenaAllocNoZero(temp.arena, 4096));
+    scvScratchEnd(temp);
+  }
+  BenchReport("scratch begin/alloc/end", BENCH_ITERATIONS, scvTimerToc(&timer, SCV_NS));
+  scvScratchReset();
+
+  scvAssert(scvThreadCreate(&thread, BenchScratchThread, nil));
+  pthread_join(thread, &base);
+  scvAssert(scvSyscall(SYS_madvise, (uptr)base, SCV_PAGE_SIZE, MADV_NORMAL).err == ENOMEM);
+
+  stats = scvArenaStats(&arena);
+  scvPrintMemStats("bench arena", &stats);
+
+  scvArenaRelease(&arena);
+}
+
+#define BENCH_POOL_THREADS 8
+#define BENCH_POOL_BATCH   16
+
+void
+BenchPool(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVPool pool = {0};
+  SCVSlice mem;
+  void *chunks[BENCH_POOL_BATCH];
+  u64 i, j, iterations;
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  iterations = BENCH_ITERATIONS / BENCH_POOL_BATCH;
+
+  mem = scvMakeSlice(&arena, u8, 0, BENCH_POOL_BATCH * 64);
+  scvPoolInitDefault(&pool, mem, 64);
+  scvTimerTic(&timer);
+  for (i = 0; i < iterations; ++i) {
+    for (j = 0; j < BENCH_POOL_BATCH; ++j) {
+      chunks[j] = scvPoolAlloc(&pool);
+    }
+    for (j = 0; j < BENCH_POOL_BATCH; ++j) {
+      scvPoolFree(&pool, chunks[j]);
+    }
+  }
+  BenchReport("pool alloc+free", iterations * BENCH_POOL_BATCH, scvTimerToc(&timer, SCV_NS));
+
+  chunks[0] = scvPoolAlloc(&pool);
+  scvAssert(scvPoolStats(&pool).used == pool.chunkSize);
+  scvPoolFree(&pool, chunks[0]);
+  scvAssert(scvPoolStats(&pool).used == 0);
+
+  scvArenaRelease(&arena);
+}
+
+typedef struct BenchPoolWork BenchPoolWork;
+struct BenchPoolWork {
+  SCVSlabPool *pool;
+  u64         iterations;
+  u64         id;
+};
+
+// every chunk is stamped with owner and checked before free, so chunk
+// handed out twice or handle resolving to wrong chunk fails assert
+void*
+BenchSlabPoolWorker(void *arg)
+{
+  BenchPoolWork *work = arg;
+  SCVHandle handles[BENCH_POOL_BATCH];
+  u64 *chunks[BENCH_POOL_BATCH];
+  u64 i, j;
+
+  for (i = 0; i < work->iterations; ++i) {
+    for (j = 0; j < BENCH_POOL_BATCH; ++j) {
+      handles[j] = scvSlabPoolAlloc(work->pool, (void **)&chunks[j]);
+      *chunks[j] = work->id << 32 | j;
+    }
+    for (j = 0; j < BENCH_POOL_BATCH; ++j) {
+      scvAssert(scvSlabPoolGet(work->pool, handles[j]) == chunks[j]);
+      scvAssert(*chunks[j] == (work->id << 32 | j));
+      scvSlabPoolFree(work->pool, handles[j]);
+    }
+  }
+
+  return nil;
+}
+
+void
+BenchSlabPoolContended(void)
+{
+  SCVTimer timer = {0};
+  SCVError error = {0};
+  SCVSlabPool pool;
+  BenchPoolWork work[BENCH_POOL_THREADS];
+  SCVThread threads[BENCH_POOL_THREADS];
+  u64 t, iterations, capacity;
+
+  scvInitTimer(&timer);
+  scvSlabPoolInitDefault(&pool, 64, 16, &error);
+  scvAssert(error.tag == 0);
+  iterations = BENCH_ITERATIONS / BENCH_POOL_BATCH;
+
+  work[0] = (BenchPoolWork){ &pool, iterations, 0 };
+  scvTimerTic(&timer);
+  BenchSlabPoolWorker(&work[0]);
+  BenchReport("slab pool alloc+free 1 thread", iterations * BENCH_POOL_BATCH, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (t = 0; t < BENCH_POOL_THREADS; ++t) {
+    work[t] = (BenchPoolWork){ &pool, iterations, t };
+    scvAssert(scvThreadCreate(&threads[t], BenchSlabPoolWorker, &work[t]));
+  }
+  for (t = 0; t < BENCH_POOL_THREADS; ++t) {
+    scvThreadJoin(threads[t]);
+  }
+  BenchReport("slab pool alloc+free 8 threads", BENCH_POOL_THREADS * iterations * BENCH_POOL_BATCH,
+      scvTimerToc(&timer, SCV_NS));
+
+  // everything came back, and pool grew only while all its slots were held
+  scvAssert(scvSlabPoolStats(&pool).tagCount[pool.tag] == 0);
+  capacity = (u64)pool.slabBase * ((1ull << pool.slabCount) - 1);
+  scvAssert(capacity <= 2 * BENCH_POOL_THREADS * BENCH_POOL_BATCH + pool.slabBase);
+
+  scvSlabPoolRelease(&pool);
+}
+
+void
+BenchSlabPool(void)
+{
+  SCVTimer timer = {0};
+  SCVError error = {0};
+  SCVSlabPool pool;
+  SCVSlice handles;
+  SCVArena arena = {0};
+  SCVHandle *h;
+  u64 i, count = BENCH_ITERATIONS / 2;
+  u64 sink = 0;
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvSlabPoolInitDefault(&pool, 64, 16, &error);
+  scvAssert(error.tag == 0);
+  handles = scvMakeSlice(&arena, SCVHandle, count, count);
+  h = handles.base;
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    h[i] = scvSlabPoolAlloc(&pool, nil);
+  }
+  BenchReport("slab pool alloc growing", count, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    sink += (uptr)scvSlabPoolGet(&pool, h[i]);
+  }
+  BenchReport("slab pool get", count, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; i += 2) {
+    scvSlabPoolFree(&pool, h[i]);
+  }
+  BenchReport("slab pool free", count / 2, scvTimerToc(&timer, SCV_NS));
+
+  for (i = 0; i < count; ++i) {
+    scvAssert((scvSlabPoolGet(&pool, h[i]) == nil) == (i % 2 == 0));
+  }
+  for (i = 0; i < count; i += 2) {
+    scvAssert(scvSlabPoolGet(&pool, scvSlabPoolAlloc(&pool, nil)));
+  }
+
+  unused(sink);
+  scvSlabPoolRelease(&pool);
+  scvArenaRelease(&arena);
+}
+
+// checks bulk decoder against scvUTF8GetNext on valid input and that
+// both reject malformed input
+void
+CheckUTF8(SCVArena *arena)
+{
+  char *valid[] = {
+    "",
+    "plain ascii log line which is longer than one simd block of 32 bytes",
+    "абвгдеёжзиклмнопрст",
+    "mixed ascii and кириллица, then ascii again 0123456789abcdef0123456789",
+    "\xe2\x82\xac \xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf end",
+  };
+  char *invalid[] = {
+    "\x80",
+    "overlong \xc0\xaf",
+    "surrogate \xed\xa0\x80",
+    "too big \xf4\x90\x80\x80",
+    "bad continuation \xe2\x28\xa1 after ascii block of 32 bytes or more",
+    "truncated \xe2\x82",
+  };
+  SCVError error;
+  SCVSlice runes;
+  SCVUTF8Iterator iterator;
+  u64 i, j;
+
+  for (i = 0; i < sizeof(valid) / sizeof(valid[0]); ++i) {
+    scvClear(&error, sizeof(error));
+    runes = scvUTF8DecodeToSlice(arena, scvUnsafeCString(valid[i]), &error);
+    scvAssert(error.tag == 0);
+    iterator = scvUTF8IteratorCString(valid[i]);
+    for (j = 0; scvUTF8HasNext(&iterator); ++j) {
+      scvAssert(j < runes.len);
+      scvAssert(((rune *)runes.base)[j] == scvUTF8GetNext(&iterator, &error));
+    }
+    scvAssert(j == runes.len);
+  }
+
+  for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    scvAssert(!scvUTF8Validate(scvUnsafeCString(invalid[i])));
+  }
+}
+
+void
+BenchUTF8(void)
+{
+  SCVTimer timer = {0};
+  SCVError error = {0};
+  SCVArena arena = {0};
+  SCVUTF8Iterator iterator;
+  SCVString line = scvUnsafeCString("[info] 12:00:01.123 bundle loaded in 245ms, modules=1834 абв\n");
+  SCVSlice text, runes;
+  u64 i, n, textlen = 64 << 20, runesCount = 0;
+  rune sink = 0;
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  CheckUTF8(&arena);
+
+  text = scvMakeSlice(&arena, u8, 0, textlen);
+  for (n = 0; n + line.len <= textlen; n += line.len) {
+    memcpy((u8 *)text.base + n, line.base, line.len);
+  }
+  text.len = n;
+
+  scvTimerTic(&timer);
+  iterator = scvUTF8Iterator(scvString(text));
+  while (scvUTF8HasNext(&iterator)) {
+    sink ^= scvUTF8GetNext(&iterator, &error);
+    ++runesCount;
+  }
+  BenchReport("utf8 iterator 64mb, per rune", runesCount, scvTimerToc(&timer, SCV_NS));
+
+  // touch output pages first, so only decoding is measured
+  runes = scvMakeSlice(&arena, rune, 0, text.len);
+  scvUTF8Decode(scvString(text), runes.base, &error);
+  scvTimerTic(&timer);
+  n = scvUTF8Decode(scvString(text), runes.base, &error);
+  BenchReport("utf8 bulk decode 64mb, per rune", n, scvTimerToc(&timer, SCV_NS));
+  scvAssert(n == runesCount && error.tag == 0);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < 10; ++i) {
+    scvAssert(scvUTF8Validate(scvString(text)));
+  }
+  BenchReport("utf8 bulk validate 64mb, per 10 runs", 10, scvTimerToc(&timer, SCV_NS));
+
+  // pure ascii text, the common case for js logs
+  for (i = 0; i < text.len; ++i) {
+    ((u8 *)text.base)[i] &= 0x7f;
+  }
+
+  runesCount = 0;
+  scvTimerTic(&timer);
+  iterator = scvUTF8Iterator(scvString(text));
+  while (scvUTF8HasNext(&iterator)) {
+    sink ^= scvUTF8GetNext(&iterator, &error);
+    ++runesCount;
+  }
+  BenchReport("utf8 iterator 64mb ascii, per rune", runesCount, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  n = scvUTF8Decode(scvString(text), runes.base, &error);
+  BenchReport("utf8 bulk decode 64mb ascii, per rune", n, scvTimerToc(&timer, SCV_NS));
+  scvAssert(n == runesCount && error.tag == 0);
+
+  unused(sink);
+  scvArenaRelease(&arena);
+}
+
+void*
+BenchLogThread(void *arg)
+{
+  scvInfoArgs("bench", "short lived thread", (u64)(uptr)arg);
+  return nil;
+}
+
+// threads which come and go one after another share one ring
+void
+CheckLogRings(void)
+{
+  SCVLogRing *ring;
+  SCVThread thread;
+  u64 i, before = 0, after = 0;
+
+  scvLogStart(&((SCVLogDesc){
+    .overflow = SCV_LOG_OVERFLOW_BLOCK,
+    .fd = scvOpenCString("/dev/null", O_WRONLY, nil),
+  }));
+  for (ring = scvAtomicLoad(&scvLogger.rings); ring; ring = ring->next) {
+    before++;
+  }
+  for (i = 0; i < 16; ++i) {
+    scvAssert(scvThreadCreate(&thread, BenchLogThread, (void *)(uptr)i));
+    scvThreadJoin(thread);
+  }
+  scvLogFlush();
+  for (ring = scvAtomicLoad(&scvLogger.rings); ring; ring = ring->next) {
+    after++;
+  }
+  scvAssert(after <= before + 1);
+  scvLogStop();
+  scvClose(scvLogger.fd);
+  scvLogger.fd = 0;
+}
+
+// record logged before flush is in file when flush returns
+void
+CheckLogFlush(void)
+{
+  char *path = "/tmp/scv_bench_log.txt";
+  SCVError error = {0};
+  struct stat st;
+  i64 size = 0;
+  i32 fd;
+  u64 i;
+
+  fd = scvOpenat(AT_FDCWD, scvUnsafeCString(path), O_WRONLY | O_CREAT | O_TRUNC, 0644, &error);
+  scvAssert(error.tag == 0);
+  scvLogStart(&((SCVLogDesc){ .overflow = SCV_LOG_OVERFLOW_BLOCK, .fd = fd }));
+  for (i = 0; i < 1000; ++i) {
+    scvInfoArgs("bench", "flushed record", i, 0);
+    scvLogFlush();
+    scvFStat(fd, &st, &error);
+    scvAssert(error.tag == 0 && st.st_size > size);
+    size = st.st_size;
+  }
+  scvLogStop();
+  scvFStat(fd, &st, &error);
+  scvAssert(st.st_size == size);
+  scvClose(fd);
+  scvLogger.fd = 0;
+  scvSyscall(SYS_unlinkat, AT_FDCWD, (uptr)path, 0);
+}
+
+#define BENCH_LOG_SPARSE 1000
+
+// records far apart, as warnings during a frame: drain thread is idle
+// every time, only the call itself is timed
+void
+BenchLogSparse(char *name)
+{
+  struct timespec gap = { 0, 200000 };
+  SCVTimer timer = {0};
+  u64 i, ns = 0;
+
+  scvInitTimer(&timer);
+  for (i = 0; i < BENCH_LOG_SPARSE; ++i) {
+    nanosleep(&gap, nil);
+    scvTimerTic(&timer);
+    scvInfoArgs("bench", "sparse record", i, 0);
+    ns += scvTimerToc(&timer, SCV_NS);
+  }
+  BenchReport(name, BENCH_LOG_SPARSE, ns);
+}
+
+void
+BenchLog(void)
+{
+  SCVTimer timer = {0};
+  u64 i, count = BENCH_ITERATIONS / 10;
+
+  scvInitTimer(&timer);
+  scvLogStart(&((SCVLogDesc){
+    .overflow = SCV_LOG_OVERFLOW_BLOCK,
+    .fd = scvOpenCString("/dev/null", O_WRONLY, nil),
+  }));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvInfoArgs("bench", "log record", i, i * 2);
+  }
+  BenchReport("async log call", count, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  scvLogFlush();
+  BenchReport("async log flush after calls", count, scvTimerToc(&timer, SCV_NS));
+  BenchLogSparse("async log call sparse");
+  scvLogFlush();
+  scvLogStop();
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvInfoArgs("bench", "log record", i, i * 2);
+  }
+  BenchReport("sync log call", count, scvTimerToc(&timer, SCV_NS));
+  BenchLogSparse("sync log call sparse");
+  scvLogger.fd = 0;
+
+  CheckLogFlush();
+  CheckLogRings();
+}
+
+// NOTE: libc here only as reference to check against and race with
+u64
+RandomU64(u64 *state)
+{
+  u64 x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *state = x;
+
+  return x;
+}
+
+void
+CheckFormat(void)
+{
+  f64 values[] = { 0.0, -0.0, 1.0, -1.5, 0.1, 0.3, 1e21, 1e-7, 123456789.0,
+                   5e-324, 1.7976931348623157e308, 2.2250738585072014e-308,
+                   0.000001, 1e20, 3.14159265358979 };
+  char *shortest[] = { "0", "0.1", "0.3", "-1.5", "1e21", "1e-7", "5e-324",
+                       "1.7976931348623157e308", "0.000001", "123456789",
+                       "100000000000000000000", "1.2345e-8" };
+  char buf[SCV_F64_MAX_CHARS + 1];
+  u64 i, n, bits, state = 0x9e3779b97f4a7c15ull;
+  f64 x;
+
+  for (i = 0; i < 1000000 + sizeof(values) / sizeof(values[0]); ++i) {
+    if (i < sizeof(values) / sizeof(values[0])) {
+      x = values[i];
+    } else {
+      bits = RandomU64(&state);
+      memcpy(&x, &bits, sizeof(x));
+      if (x != x || x - x != 0) {
+        continue;
+      }
+    }
+    n = scvFormatF64(buf, x);
+    buf[n] = 0;
+    scvAssert(strtod(buf, nil) == x);
+  }
+  for (i = 0; i < sizeof(shortest) / sizeof(shortest[0]); ++i) {
+    n = scvFormatF64(buf, strtod(shortest[i], nil));
+    buf[n] = 0;
+    scvAssert(strcmp(buf, shortest[i]) == 0);
+  }
+
+  for (i = 0; i < 1000000; ++i) {
+    u64 y = RandomU64(&state) >> (i % 64);
+    n = scvFormatU64(buf, y);
+    buf[n] = 0;
+    scvAssert(strtoull(buf, nil, 10) == y);
+  }
+
+  // -2.005 * 100 rounds to exactly -200.5 before rounding to integer
+  n = scvFormatF64Fixed(buf, -2.005, 2);
+  buf[n] = 0;
+  scvAssert(strcmp(buf, "-2.01") == 0);
+  n = scvFormatF64Fixed(buf, -2.5, 0);
+  buf[n] = 0;
+  scvAssert(strcmp(buf, "-3") == 0);
+  n = scvFormatF64Fixed(buf, -0.001, 2);
+  buf[n] = 0;
+  scvAssert(strcmp(buf, "0.00") == 0);
+  n = scvFormatF64Fixed(buf, 1.5, 3);
+  buf[n] = 0;
+  scvAssert(strcmp(buf, "1.500") == 0);
+  n = scvFormatHex(buf, 0xbeef, 8);
+  buf[n] = 0;
+  scvAssert(strcmp(buf, "0000beef") == 0);
+}
+
+void
+BenchWriter(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVWriter w;
+  SCVError error = {0};
+  char out[1 << 16];
+  char buf[64];
+  u64 i, n, sink = 0, count = BENCH_ITERATIONS;
+  f64 x;
+
+  CheckFormat();
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    sink += (u64)snprintf(buf, sizeof(buf), "%llu", (unsigned long long)(i * 7919));
+  }
+  BenchReport("snprintf u64", count, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    sink += scvFormatU64(buf, i * 7919);
+  }
+  BenchReport("scvFormatU64", count, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    x = (f64)i * 1.0000001;
+    sink += (u64)snprintf(buf, sizeof(buf), "%.17g", x);
+  }
+  BenchReport("snprintf %.17g", count, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    x = (f64)i * 1.0000001;
+    sink += scvFormatF64(buf, x);
+  }
+  BenchReport("scvFormatF64", count, scvTimerToc(&timer, SCV_NS));
+
+  scvWriterFd(&w, scvOpenCString("/dev/null", O_WRONLY, nil), scvUnsafeSlice(out, sizeof(out)));
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvWriterPutCString(&w, "v=");
+    scvWriterPutU64(&w, i);
+    scvWriterPutByte(&w, ' ');
+    scvWriterPutF64Fixed(&w, (f64)i * 0.25, 2);
+    scvWriterPutByte(&w, '\n');
+  }
+  scvWriterFlush(&w);
+  BenchReport("fd writer line", count, scvTimerToc(&timer, SCV_NS));
+  scvClose(w.fd);
+
+  scvWriterArena(&w, &arena, 64);
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvWriterPutHex(&w, i, 8);
+    scvWriterPutByte(&w, '\n');
+  }
+  BenchReport("arena writer hex line", count, scvTimerToc(&timer, SCV_NS));
+  scvAssert(w.len == count * 9 && !w.err.tag);
+  n = arena.currOffset;
+  scvAssert(n < w.len * 2);
+
+  unused(sink);
+  scvArenaRelease(&arena);
+}
+
+u64
+SumBytes(u8 *p, u64 len)
+{
+  u64 i, sum = 0;
+
+  for (i = 0; i < len; i += 64) {
+    sum += p[i];
+  }
+
+  return sum;
+}
+
+void
+BenchFiles(void)
+{
+  char *path = "/tmp/scv_bench_file";
+  u64 size = 256ull << 20, chunkSize = 1 << 20, i, sum, expected = 0, offset;
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVMappedFile file;
+  SCVFileReader reader;
+  SCVString chunk;
+  SCVSlice buf;
+  i32 fd;
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  buf = scvMakeSlice(&arena, u8, chunkSize, chunkSize);
+  for (i = 0; i < chunkSize; ++i) {
+    ((u8 *)buf.base)[i] = (u8)(i * 31 + (i >> 12));
+  }
+
+  fd = scvOpenat(AT_FDCWD, scvUnsafeCString(path), O_WRONLY | O_CREAT | O_TRUNC, 0644, &error);
+  scvAssert(error.tag == 0);
+  for (offset = 0; offset < size; offset += chunkSize) {
+    scvAssert(scvWrite(fd, buf.base, chunkSize, &error) == (i64)chunkSize);
+    expected += SumBytes(buf.base, chunkSize);
+  }
+  scvClose(fd);
+
+  scvTimerTic(&timer);
+  file = scvMapFile(scvUnsafeCString(path), nil, &error);
+  scvAssert(error.tag == 0 && file.len == size);
+  sum = SumBytes(file.base, file.len);
+  BenchReport("map 256mb + touch every cache line", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(sum == expected);
+  scvUnmapFile(&file);
+
+  scvTimerTic(&timer);
+  file = scvMapFile(scvUnsafeCString(path), &((SCVFileMapDesc){
+    .access = SCV_FILE_ACCESS_SEQUENTIAL,
+    .populate = true,
+  }), &error);
+  sum = SumBytes(file.base, file.len);
+  BenchReport("map 256mb populate sequential + touch", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(sum == expected);
+  scvUnmapFile(&file);
+
+  scvTimerTic(&timer);
+  scvFileReaderOpen(&reader, scvUnsafeCString(path), buf, &error);
+  scvAssert(error.tag == 0);
+  sum = 0;
+  for (chunk = scvFileReaderNext(&reader); chunk.len; chunk = scvFileReaderNext(&reader)) {
+    sum += SumBytes(chunk.base, chunk.len);
+  }
+  scvFileReaderClose(&reader);
+  BenchReport("stream 256mb in 1mb chunks", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(reader.err.tag == 0 && reader.offset == size && sum == expected);
+
+  file = scvMapFile(scvUnsafeCString("/nonexistent/scv"), nil, &error);
+  scvAssert(error.tag != 0 && file.base == nil);
+
+  scvSyscall(SYS_unlinkat, AT_FDCWD, (uptr)path, 0);
+  scvArenaRelease(&arena);
+}
+
+// just under 7/16 of 2048 slots: map stops growing there, and removes
+// leave tombstones often enough to need same capacity rehash
+#define CHECK_MAP_LIVE 880
+
+// sliding window of live keys, tombstones are cleaned in place so map
+// memory doesn't grow with number of removes
+void
+CheckMapChurn(bool stringKeys)
+{
+  SCVArena arena = {0}, keyArena = {0};
+  SCVError error = {0};
+  SCVString *keys;
+  SCVMap map;
+  u64 i, j, *v, used = 0, count = 1000000;
+  char *buf;
+
+  scvArenaInit(&arena, &error);
+  scvArenaInit(&keyArena, &error);
+  scvAssert(error.tag == 0);
+  keys = scvArenaAlloc(&keyArena, count * sizeof(SCVString));
+  for (i = 0; i < count; ++i) {
+    buf = scvArenaAlloc(&keyArena, 24);
+    memcpy(buf, "key_", 4);
+    keys[i] = scvUnsafeString((u8 *)buf, 4 + scvFormatU64(buf + 4, i));
+  }
+
+  scvMapInit(&map, &arena, CHECK_MAP_LIVE, stringKeys);
+  for (i = 0; i < count; ++i) {
+    if (i >= CHECK_MAP_LIVE) {
+      j = i - CHECK_MAP_LIVE;
+      scvAssert(scvMapRemoveKey(&map, j * 0x9e3779b9ull, keys[j]));
+    }
+    scvMapPutKey(&map, i * 0x9e3779b9ull, keys[i], i);
+    if (i == count / 2) {
+      used = arena.currOffset;
+    }
+  }
+  scvAssert(arena.currOffset == used);
+  scvAssert(map.len == CHECK_MAP_LIVE);
+  for (i = 0; i < count; ++i) {
+    v = scvMapGetKey(&map, i * 0x9e3779b9ull, keys[i]);
+    scvAssert(i < count - CHECK_MAP_LIVE ? v == nil : v && *v == i);
+  }
+
+  scvArenaRelease(&keyArena);
+  scvArenaRelease(&arena);
+}
+
+void
+BenchMap(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVMap map;
+  SCVInterner interner;
+  SCVString s;
+  u64 i, *v, count = 4 * BENCH_ITERATIONS, strCount = BENCH_ITERATIONS;
+  u64 found = 0;
+  char buf[32] = "source/file_";
+  u32 id;
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  scvMapInit(&map, &arena, 16, false);
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvMapPutU64(&map, i * 0x9e3779b9ull, i);
+  }
+  BenchReport("map put 4m u64 keys, growing from 16", count, scvTimerToc(&timer, SCV_NS));
+  scvAssert(map.len == count);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    v = scvMapGetU64(&map, i * 0x9e3779b9ull);
+    found += v ? *v == i : 0;
+  }
+  BenchReport("map get 4m hits", count, scvTimerToc(&timer, SCV_NS));
+  scvAssert(found == count);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    found += scvMapGetU64(&map, i * 0x9e3779b9ull + 1) != nil;
+  }
+  BenchReport("map get 4m misses", count, scvTimerToc(&timer, SCV_NS));
+  scvAssert(found == count);
+
+  for (i = 0; i < count; i += 2) {
+    scvAssert(scvMapRemoveU64(&map, i * 0x9e3779b9ull));
+  }
+  for (i = 0; i < count; ++i) {
+    v = scvMapGetU64(&map, i * 0x9e3779b9ull);
+    scvAssert((i & 1) ? v && *v == i : v == nil);
+  }
+  for (i = 0; i < count; i += 2) {
+    scvMapPutU64(&map, i * 0x9e3779b9ull, i);
+  }
+  scvAssert(map.len == count);
+
+  CheckMapChurn(false);
+  CheckMapChurn(true);
+
+  scvInternerInit(&interner, &arena, 1024);
+  scvTimerTic(&timer);
+  for (i = 0; i < strCount; ++i) {
+    s.base = (u8 *)buf;
+    s.len = 12 + scvFormatU64(buf + 12, i);
+    id = scvIntern(&interner, s);
+    scvAssert(id == i + 1);
+  }
+  BenchReport("intern 1m new strings", strCount, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < strCount; ++i) {
+    s.base = (u8 *)buf;
+    s.len = 12 + scvFormatU64(buf + 12, i);
+    id = scvIntern(&interner, s);
+    scvAssert(id == i + 1);
+  }
+  BenchReport("intern 1m repeated strings", strCount, scvTimerToc(&timer, SCV_NS));
+
+  s = scvInternGet(&interner, 43);
+  scvAssert(s.len == 14 && memcmp(s.base, "source/file_42", 15) == 0);
+  scvAssert(scvInternFind(&interner, scvUnsafeCString("missing")) == 0);
+
+  scvArenaRelease(&arena);
+}
+
+i64
+NaiveIndex(SCVString s, SCVString needle, bool fold)
+{
+  u64 i;
+
+  for (i = 0; i + needle.len <= s.len; ++i) {
+    if (fold ? scvMemEqualsFold(s.base + i, needle.base, needle.len)
+             : memcmp(s.base + i, needle.base, needle.len) == 0) {
+      return (i64)i;
+    }
+  }
+
+  return -1;
+}
+
+void
+CheckSearch(void)
+{
+  u8 text[256];
+  u64 i, j, len, state = 0x12345678ull;
+  SCVString s, needle;
+  SCVLineIterator it;
+
+  scvAssert(scvIsStringsEquals(scvUnsafeCString("abc"), scvUnsafeCString("abc")));
+  scvAssert(!scvIsStringsEquals(scvUnsafeCString("abc"), scvUnsafeCString("abd")));
+  scvAssert(scvIsStringsEqualsFold(scvUnsafeCString("Hello"), scvUnsafeCString("hELLO")));
+
+  // small alphabet so matches and near matches happen often
+  for (i = 0; i < 100000; ++i) {
+    len = RandomU64(&state) % sizeof(text);
+    for (j = 0; j < len; ++j) {
+      text[j] = "abAB\n["[RandomU64(&state) % 6];
+    }
+    s = scvUnsafeString(text, len);
+    j = RandomU64(&state) % 5;
+    needle = scvUnsafeString(text + (len ? RandomU64(&state) % len : 0), scvMin(j, len));
+    scvAssert(scvStringIndex(s, needle) == NaiveIndex(s, needle, false));
+    scvAssert(scvStringIndexFold(s, needle) == NaiveIndex(s, needle, true));
+    scvAssert(scvStringIndexByte(s, 'B') == NaiveIndex(s, scvUnsafeCString("B"), false));
+  }
+
+  it = scvLineIterator(scvUnsafeCString("one\r\ntwo\n\nthree"));
+  scvAssert(scvIsStringsEquals(scvLineGetNext(&it), scvUnsafeCString("one")));
+  scvAssert(scvIsStringsEquals(scvLineGetNext(&it), scvUnsafeCString("two")));
+  scvAssert(scvLineGetNext(&it).len == 0);
+  scvAssert(scvIsStringsEquals(scvLineGetNext(&it), scvUnsafeCString("three")));
+  scvAssert(!scvLineHasNext(&it));
+}
+
+void
+BenchSearch(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVWriter w;
+  SCVString text, line;
+  SCVSlice lines;
+  SCVLineIterator it;
+  u64 i, count = BENCH_ITERATIONS, matched = 0;
+
+  CheckSearch();
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  lines = scvMakeSlice(&arena, SCVString, 0, count);
+  scvWriterArena(&w, &arena, 64ull << 20);
+  for (i = 0; i < count; ++i) {
+    scvWriterPutCString(&w, "[info] frame ");
+    scvWriterPutU64(&w, i);
+    scvWriterPutCString(&w, (i % 1000) ? " drawcalls flushed in " : " Texture Upload took ");
+    scvWriterPutF64Fixed(&w, (f64)(i % 97) * 0.013, 3);
+    scvWriterPutCString(&w, " ms\n");
+  }
+  text = scvWriterString(&w);
+
+  scvTimerTic(&timer);
+  matched = scvStringCountByte(text, '\n');
+  BenchReport("count lines in 1m line buffer", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(matched == count);
+
+  scvTimerTic(&timer);
+  matched = scvFilterLines(text, scvUnsafeCString("texture upload"), true, &lines);
+  BenchReport("filter 1m lines, ignore case", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(matched == count / 1000 && lines.len == matched);
+
+  scvTimerTic(&timer);
+  matched = scvFilterLines(text, scvUnsafeCString("Upload"), false, &lines);
+  BenchReport("filter 1m lines, exact", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(matched == count / 1000);
+
+  scvTimerTic(&timer);
+  matched = 0;
+  for (it = scvLineIterator(text); scvLineHasNext(&it);) {
+    line = scvLineGetNext(&it);
+    matched += scvStringIndexFold(line, scvUnsafeCString("texture upload")) >= 0;
+  }
+  BenchReport("filter 1m lines line by line, ignore case", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(matched == count / 1000);
+
+  scvArenaRelease(&arena);
+}
+
+void*
+BenchProfileWorker(void *arg)
+{
+  u64 i, count = (u64)(uptr)arg;
+
+  for (i = 0; i < count; ++i) {
+    scvProfileBegin("worker item");
+    scvProfileBegin("worker inner");
+    scvProfileEnd();
+    scvProfileEnd();
+  }
+
+  return nil;
+}
+
+void
+BenchProfile(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVThread thread;
+  SCVSlice stats;
+  SCVZoneStats *z;
+  SCVWriter w;
+  u8 out[4096];
+  u64 a[1000], i, j, k, state = 42, count = BENCH_ITERATIONS / 4;
+
+  // selection against brute force rank
+  for (i = 0; i < 200; ++i) {
+    for (j = 0; j < 1000; ++j) {
+      a[j] = RandomU64(&state) % 50;
+    }
+    k = RandomU64(&state) % 1000;
+    u64 v = scvSelectU64(a, 1000, k), less = 0, lessEq = 0;
+    for (j = 0; j < 1000; ++j) {
+      less += a[j] < v;
+      lessEq += a[j] <= v;
+    }
+    scvAssert(less <= k && k < lessEq);
+  }
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvZoneBegin("disabled");
+    scvZoneEnd();
+  }
+  BenchReport("zone begin+end compiled out", count, scvTimerToc(&timer, SCV_NS));
+
+  scvProfileReset();
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvProfileBegin("bench zone");
+    scvProfileEnd();
+  }
+  BenchReport("zone begin+end recorded, first touch", count, scvTimerToc(&timer, SCV_NS));
+
+  scvProfileReset();
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvProfileBegin("bench zone");
+    scvProfileEnd();
+  }
+  BenchReport("zone begin+end recorded", count, scvTimerToc(&timer, SCV_NS));
+
+  scvAssert(scvThreadCreate(&thread, BenchProfileWorker, (void *)(uptr)(count / 4)));
+  for (i = 0; i < count / 4; ++i) {
+    scvProfileBegin("main outer");
+    scvProfileBegin("main inner");
+    scvProfileEnd();
+    scvProfileEnd();
+  }
+  scvThreadJoin(thread);
+
+  scvTimerTic(&timer);
+  stats = scvProfileAggregate(&arena);
+  BenchReport("aggregate 1.5m zones", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(stats.len == 5);
+  z = stats.base;
+  for (i = 0; i < stats.len; ++i) {
+    scvAssert(z[i].count == (strcmp(z[i].name, "bench zone") ? count / 4 : count));
+    scvAssert(z[i].minNs <= z[i].meanNs && z[i].meanNs <= z[i].maxNs);
+    scvAssert(z[i].p99Ns <= z[i].maxNs);
+  }
+  scvWriterFd(&w, 2, scvUnsafeSlice(out, sizeof(out)));
+  scvProfileWriteStats(&w, stats);
+  scvWriterFlush(&w);
+
+  scvTimerTic(&timer);
+  scvAssert(scvProfileDumpTrace("/tmp/scv_trace.json", &error));
+  BenchReport("chrome trace export 3m events", 1, scvTimerToc(&timer, SCV_NS));
+
+  // reset inside zone, events go once thread is back at outermost zone
+  scvProfileBegin("across reset");
+  scvProfileReset();
+  scvAssert(scvProfileAggregate(&arena).len == 0);
+  scvProfileEnd();
+  scvAssert(scvProfileAggregate(&arena).len == 0);
+  scvProfileBegin("after reset");
+  scvProfileEnd();
+  stats = scvProfileAggregate(&arena);
+  z = stats.base;
+  scvAssert(stats.len == 1 && z[0].count == 1 && strcmp(z[0].name, "after reset") == 0);
+
+  scvProfileReset();
+  scvArenaRelease(&arena);
+}
+
+typedef struct BenchJobData BenchJobData;
+struct BenchJobData {
+  u32 *values;
+  u64 sums[1024];
+  u64 children;
+};
+
+void
+BenchJobSum(void *data, u64 start, u64 end)
+{
+  BenchJobData *d = data;
+  u64 i, sum = 0;
+
+  for (i = start; i < end; ++i) {
+    sum += d->values[i];
+  }
+  d->sums[start / (1 << 16)] = sum;
+}
+
+void
+BenchJobEmpty(void *data, u64 start, u64 end)
+{
+  unused(data);
+  unused(start);
+  unused(end);
+}
+
+void
+BenchJobChild(void *data, u64 start, u64 end)
+{
+  BenchJobData *d = data;
+
+  unused(start);
+  unused(end);
+  scvAtomicAdd(&d->children, 1);
+}
+
+// parent waits for jobs it spawned, i.e. dependency inside job
+void
+BenchJobParent(void *data, u64 start, u64 end)
+{
+  SCVJobCounter counter = {0};
+
+  unused(start);
+  unused(end);
+  scvJobsParallelFor(BenchJobChild, data, 100, 1, &counter);
+  scvJobsWait(&counter);
+}
+
+void
+BenchJobs(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVJobCounter counter = {0};
+  BenchJobData *d;
+  u64 i, count = 64ull << 20, serial = 0, parallel = 0, jobs = BENCH_ITERATIONS;
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+  d = scvArenaAlloc(&arena, sizeof(*d));
+  d->values = scvArenaAllocNoZero(&arena, count * sizeof(u32));
+  for (i = 0; i < count; ++i) {
+    d->values[i] = (u32)(i * 2654435761u);
+  }
+
+  // at least 3 workers even on one cpu, to exercise stealing
+  scvJobsStart(&((SCVJobsDesc){ .workers = scvMax(scvCpuCount() - 1, 3) }));
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    serial += d->values[i];
+  }
+  BenchReport("sum 64m u32 serial", 1, scvTimerToc(&timer, SCV_NS));
+
+  scvTimerTic(&timer);
+  scvJobsParallelFor(BenchJobSum, d, count, 1 << 16, &counter);
+  scvJobsWait(&counter);
+  BenchReport("sum 64m u32 parallel for", 1, scvTimerToc(&timer, SCV_NS));
+  for (i = 0; i < count >> 16; ++i) {
+    parallel += d->sums[i];
+  }
+  scvAssert(parallel == serial);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < jobs; ++i) {
+    scvJobsRun(BenchJobEmpty, nil, &counter);
+    if ((i & 1023) == 1023) {
+      scvJobsWait(&counter);
+    }
+  }
+  scvJobsWait(&counter);
+  BenchReport("empty job submit+run", jobs, scvTimerToc(&timer, SCV_NS));
+
+  for (i = 0; i < 100; ++i) {
+    scvJobsRun(BenchJobParent, d, &counter);
+  }
+  scvJobsWait(&counter);
+  scvAssert(d->children == 100 * 100);
+
+  scvJobsStop();
+  scvArenaRelease(&arena);
+}
+
+void
+BenchArray(void)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVArray a, b;
+  void *first;
+  u64 i, count = 16ull << 20, chunk[64];
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+
+  scvTimerTic(&timer);
+  a = scvMakeArray(&arena, u64, 16);
+  first = a.base;
+  for (i = 0; i < count; ++i) {
+    scvArrayPush(&a, u64, i);
+  }
+  BenchReport("array push 16m u64, in place", count, scvTimerToc(&timer, SCV_NS));
+  scvAssert(a.base == first && a.len == count);
+  for (i = 0; i < count; ++i) {
+    scvAssert(*scvArrayGet(&a, u64, i) == i);
+  }
+
+  // interleaved arrays take turns being the last allocation, so they move
+  scvArenaReset(&arena);
+  scvTimerTic(&timer);
+  a = scvMakeArray(&arena, u64, 16);
+  b = scvMakeArray(&arena, u64, 16);
+  for (i = 0; i < count; ++i) {
+    scvArrayPush(&a, u64, i);
+    scvArrayPush(&b, u64, ~i);
+  }
+  BenchReport("array push 2x16m u64, interleaved", 2 * count, scvTimerToc(&timer, SCV_NS));
+  for (i = 0; i < count; ++i) {
+    scvAssert(*scvArrayGet(&a, u64, i) == i && *scvArrayGet(&b, u64, i) == ~i);
+  }
+
+  scvArenaReset(&arena);
+  for (i = 0; i < 64; ++i) {
+    chunk[i] = i;
+  }
+  scvTimerTic(&timer);
+  a = scvMakeArray(&arena, u64, 16);
+  for (i = 0; i < count; i += 64) {
+    scvArrayAppend(&a, chunk, 64);
+  }
+  BenchReport("array append 16m u64 in 64 element chunks", count, scvTimerToc(&timer, SCV_NS));
+  scvAssert(a.len == count && *scvArrayLast(&a, u64) == 63);
+
+  scvAssert(scvArrayReserve(&a, 1, &error) && error.tag == 0);
+  scvAssert(!scvArrayReserve(&a, 1ull << 60, &error) && error.tag != 0);
+
+  scvArenaRelease(&arena);
+}
+
+void
+BenchIOBackend(char *name, SCVIODesc *desc, char **paths, u64 count)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVIO io;
+  SCVIORequest reqs[8], missing, *done[8];
+  SCVMappedFile file;
+  u64 i, n, finished = 0;
+  char label[64];
+
+  scvAssert(count <= 8);
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvAssert(error.tag == 0);
+  scvIOInit(&io, desc);
+
+  scvTimerTic(&timer);
+  for (i = 0; i < count; ++i) {
+    scvIOLoad(&io, &reqs[i], scvUnsafeCString(paths[i]), &arena);
+    reqs[i].user = paths[i];
+  }
+  scvIOSubmit(&io);
+  while (finished < count) {
+    n = scvIOPoll(&io, done, 8);
+    finished += n;
+  }
+  snprintf(label, sizeof(label), "async load %llu files, %s%s", (unsigned long long)count, name,
+      io.backend == SCV_IO_BACKEND_URING ? " (io_uring)" : " (threads)");
+  BenchReport(label, 1, scvTimerToc(&timer, SCV_NS));
+
+  for (i = 0; i < count; ++i) {
+    scvAssert(reqs[i].status == SCV_IO_DONE && reqs[i].err.tag == 0);
+    file = scvMapFile(scvUnsafeCString(paths[i]), nil, &error);
+    scvAssert(error.tag == 0 && file.len == reqs[i].data.len);
+    scvAssert(memcmp(file.base, reqs[i].data.base, file.len) == 0);
+    scvAssert(reqs[i].data.base[reqs[i].data.len] == 0);
+    scvUnmapFile(&file);
+  }
+
+  scvIOLoad(&io, &missing, scvUnsafeCString("/nonexistent/scv"), &arena);
+  scvIOSubmit(&io);
+  scvIOWait(&io, &missing);
+  scvAssert(missing.status == SCV_IO_FAILED && missing.err.tag == ENOENT);
+  scvAssert(scvIOPoll(&io, done, 8) == 0);
+
+  scvIORelease(&io);
+  scvArenaRelease(&arena);
+}
+
+void
+BenchIO(void)
+{
+  char *path = "/tmp/scv_bench_io";
+  char *paths[] = { "linux_app.c", "scv.h", "scv_gl.h", path };
+  u64 size = 64ull << 20, chunkSize = 1 << 20, offset;
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVSlice buf;
+  u64 i;
+  i32 fd;
+
+  scvArenaInit(&arena, &error);
+  buf = scvMakeSlice(&arena, u8, chunkSize, chunkSize);
+  for (i = 0; i < chunkSize; ++i) {
+    ((u8 *)buf.base)[i] = (u8)(i * 17 + (i >> 10));
+  }
+  fd = scvOpenat(AT_FDCWD, scvUnsafeCString(path), O_WRONLY | O_CREAT | O_TRUNC, 0644, &error);
+  scvAssert(error.tag == 0);
+  for (offset = 0; offset < size; offset += chunkSize) {
+    scvAssert(scvWrite(fd, buf.base, chunkSize, &error) == (i64)chunkSize);
+  }
+  scvClose(fd);
+
+  BenchIOBackend("default", nil, paths, sizeof(paths) / sizeof(paths[0]));
+  BenchIOBackend("forced", &((SCVIODesc){ .forceThreads = true }), paths, sizeof(paths) / sizeof(paths[0]));
+
+  scvSyscall(SYS_unlinkat, AT_FDCWD, (uptr)path, 0);
+  scvArenaRelease(&arena);
+}
+
+u64
+ProcessCpuNs(void)
+{
+  struct timespec ts;
+
+  scvSyscall(SYS_clock_gettime, CLOCK_PROCESS_CPUTIME_ID, (uptr)&ts, 0);
+
+  return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+typedef struct BenchLoopData BenchLoopData;
+struct BenchLoopData {
+  SCVLoop *loop;
+  u64     count;
+};
+
+void*
+BenchLoopInvalidator(void *arg)
+{
+  BenchLoopData *d = arg;
+  u64 i;
+
+  for (i = 0; i < d->count; ++i) {
+    scvLoopInvalidate(d->loop);
+    // next invalidate only after loop picked this one up
+    while (scvAtomicLoad(&d->loop->dirty)) {
+      sched_yield();
+    }
+  }
+
+  return nil;
+}
+
+void
+BenchLoopIO(SCVLoop *loop, char *name, SCVIODesc *desc)
+{
+  SCVTimer timer = {0};
+  SCVArena arena = {0};
+  SCVError error = {0};
+  SCVIO io;
+  SCVIORequest req, *done[1];
+  SCVLoopEvent events[8];
+  u64 wakeups, frames = 0;
+  i32 fd;
+  char label[64];
+
+  scvInitTimer(&timer);
+  scvArenaInit(&arena, &error);
+  scvIOInit(&io, desc);
+  fd = scvIOSetNotify(&io, scvLoopInvalidateProc, loop);
+  if (fd >= 0) {
+    scvAssert(scvLoopAddFd(loop, fd, 1, &error));
+  }
+  scvLoopTakeDirty(loop);
+
+  wakeups = loop->wakeups;
+  scvTimerTic(&timer);
+  scvIOLoad(&io, &req, scvUnsafeCString("scv.h"), &arena);
+  scvIOSubmit(&io);
+  for (;;) {
+    scvLoopWait(loop, events, 8, -1);
+    if (events[0].id == 1) {
+      scvLoopInvalidate(loop);
+    }
+    if (!scvLoopTakeDirty(loop)) {
+      continue;
+    }
+    // frame
+    frames++;
+    if (scvIOPoll(&io, done, 1)) {
+      break;
+    }
+  }
+  scvAssert(req.status == SCV_IO_DONE && req.data.len > 0);
+  snprintf(label, sizeof(label), "%s, %llu wakeups, %llu frames", name,
+      (unsigned long long)(loop->wakeups - wakeups), (unsigned long long)frames);
+  BenchReport(label, 1, scvTimerToc(&timer, SCV_NS));
+
+  if (fd >= 0) {
+    scvAssert(scvLoopRemoveFd(loop, fd, &error));
+  }
+  scvIORelease(&io);
+  scvArenaRelease(&arena);
+}
+
+void
+BenchLoop(void)
+{
+  SCVTimer timer = {0};
+  SCVError error = {0};
+  SCVLoop loop;
+  SCVLoopEvent events[8];
+  SCVThread thread;
+  BenchLoopData d;
+  u64 n, cpu, frames;
+
+  scvInitTimer(&timer);
+  scvAssert(scvLoopInit(&loop, &error));
+
+  scvAssert(scvLoopTakeDirty(&loop));
+  scvAssert(!scvLoopTakeDirty(&loop));
+  scvAssert(scvLoopWait(&loop, events, 8, 0) == 0);
+
+  // idle: nothing but one timer, process must not burn cpu meanwhile
+  cpu = ProcessCpuNs();
+  scvTimerTic(&timer);
+  scvLoopSetTimer(&loop, 200000000ull, 0);
+  n = scvLoopWait(&loop, events, 8, -1);
+  scvAssert(n == 1 && events[0].id == SCV_LOOP_TIMER_ID);
+  BenchReport("idle wait for 200ms timer, wall", 1, scvTimerToc(&timer, SCV_NS));
+  BenchReport("idle wait for 200ms timer, cpu", 1, ProcessCpuNs() - cpu);
+  scvAssert(!scvLoopTakeDirty(&loop));
+
+  // many invalidates before loop gets to run collapse into one frame
+  scvLoopInvalidate(&loop);
+  scvLoopInvalidate(&loop);
+  scvLoopInvalidate(&loop);
+  n = scvLoopWait(&loop, events, 8, -1);
+  scvAssert(n == 1 && events[0].id == SCV_LOOP_WAKE_ID);
+  scvAssert(scvLoopTakeDirty(&loop));
+  scvAssert(scvLoopWait(&loop, events, 8, 0) == 0);
+
+  d.loop = &loop;
+  d.count = 10000;
+  frames = 0;
+  scvTimerTic(&timer);
+  scvAssert(scvThreadCreate(&thread, BenchLoopInvalidator, &d));
+  while (frames < d.count) {
+    scvLoopWait(&loop, events, 8, -1);
+    frames += scvLoopTakeDirty(&loop);
+  }
+  scvThreadJoin(thread);
+  BenchReport("invalidate from other thread -> frame", d.count, scvTimerToc(&timer, SCV_NS));
+
+  BenchLoopIO(&loop, "async load, default", nil);
+  BenchLoopIO(&loop, "async load, threads", &((SCVIODesc){ .forceThreads = true }));
+
+  scvLoopRelease(&loop);
+}
+
+#ifdef SCV_GL_BENCH
+
+// renderer without window, EGL surfaceless context renders offscreen.
+// Hash of last frame pixels catches output changes.
+
+#define BENCH_GL_WIDTH  1280
+#define BENCH_GL_HEIGHT 800
+#define BENCH_GL_FRAMES 30
+
+typedef struct BenchGLState BenchGLState;
+struct BenchGLState {
+  SCVArena  arena;
+  SCVGLCtx  gl;
+  SCVHandle font;
+  u32       image;
+  SCVHandle avatars[4]; // quarters of image in atlas
+  u32       fbo;
+  u32       target;
+  u8        *pixels;
+};
+
+typedef void (*BenchGLScene)(BenchGLState *b, u64 frame);
+
+void
+BenchGLInitContext(void)
+{
+  EGLDisplay display;
+  EGLContext context;
+  EGLConfig config;
+  EGLint count = 0;
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay;
+  EGLint configAttribs[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  EGLint contextAttribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+
+  display = EGL_NO_DISPLAY;
+  getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (getPlatformDisplay) {
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nil);
+  }
+  if (display == EGL_NO_DISPLAY) {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  scvAssert(eglInitialize(display, nil, nil));
+  scvAssert(eglChooseConfig(display, configAttribs, &config, 1, &count) && count == 1);
+  scvAssert(eglBindAPI(EGL_OPENGL_API));
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+  scvAssert(context != EGL_NO_CONTEXT);
+  scvAssert(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context));
+  scvPrint("gl renderer: ");
+  scvPrintCString((char *)glGetString(GL_RENDERER));
+}
+
+void
+BenchGLSceneRects(BenchGLState *b, u64 frame)
+{
+  u64 i;
+  f32 x, y;
+
+  for (i = 0; i < 10000; ++i) {
+    x = (f32)((i * 37 + frame * 3) % (BENCH_GL_WIDTH - 16));
+    y = (f32)((i * 53) % (BENCH_GL_HEIGHT - 16));
+    scvGLDrawRect(&b->gl, (SCVRect){ .origin = { x, y }, .size = { 12.0f, 12.0f } },
+        (SCVColor){ (u8)i, (u8)(i >> 3), (u8)(255 - i), 255 });
+  }
+}
+
+void
+BenchGLSceneText(BenchGLState *b, u64 frame)
+{
+  SCVString line = scvUnsafeCString(
+      "I/ReactNativeJS: fetch done in 12ms status=200 абвгдеёжзиклмнопрст {\"id\": 42}");
+  SCVFont *font = scvGetFont(&b->gl, b->font);
+  u64 i;
+
+  (void)frame;
+  for (i = 0; i < 200; ++i) {
+    // repeats land on the same spot, so output stays readable
+    scvDrawText(&b->gl, (SCVColor){ 20, 20, 20, 255 }, font,
+        (SCVPoint){ 4.0f, (f32)(i % 44) * 18.0f }, line);
+  }
+}
+
+// codepoints past latin and cyrillic, every frame goes further so first
+// frames rasterize glyphs they meet and later ones find them cached
+void
+BenchGLSceneUnicode(BenchGLState *b, u64 frame)
+{
+  SCVFont *font = scvGetFont(&b->gl, b->font);
+  u8 line[64 * 2];
+  rune cp;
+  u64 i, j;
+
+  for (i = 0; i < 44; ++i) {
+    for (j = 0; j < 64; ++j) {
+      // U+00A0..U+052F, latin supplement up to cyrillic supplement, 2 bytes each
+      cp = 0xa0 + (rune)((frame * 64 + i * 16 + j) % (0x530 - 0xa0));
+      line[2 * j]     = (u8)(0xc0 | (cp >> 6));
+      line[2 * j + 1] = (u8)(0x80 | (cp & 0x3f));
+    }
+    scvDrawText(&b->gl, (SCVColor){ 20, 20, 20, 255 }, font,
+        (SCVPoint){ 4.0f, (f32)i * 18.0f }, scvUnsafeString(line, sizeof(line)));
+  }
+}
+
+// image and text interleaved, texture changes on every element
+void
+BenchGLSceneMixed(BenchGLState *b, u64 frame)
+{
+  SCVString line = scvUnsafeCString("W/ReactNativeJS: slow render of <FlatList> 48ms");
+  SCVFont *font = scvGetFont(&b->gl, b->font);
+  u64 i;
+  f32 y;
+
+  (void)frame;
+  for (i = 0; i < 200; ++i) {
+    y = (f32)(i % 44) * 18.0f;
+    scvGLDrawImage(&b->gl, (SCVRect){ .origin = { 2.0f, y }, .size = { 16.0f, 16.0f } },
+        (SCVColor){ 255, 255, 255, 255 }, b->image);
+    scvGLDrawRect(&b->gl, (SCVRect){ .origin = { 22.0f, y }, .size = { 6.0f, 16.0f } },
+        (SCVColor){ 200, 40, 40, 255 });
+    scvDrawText(&b->gl, (SCVColor){ 20, 20, 20, 255 }, font,
+        (SCVPoint){ 32.0f, y }, line);
+  }
+}
+
+// same as mixed, but images come from atlas, so do glyphs and rects
+void
+BenchGLSceneAtlas(BenchGLState *b, u64 frame)
+{
+  SCVString line = scvUnsafeCString("W/ReactNativeJS: slow render of <FlatList> 48ms");
+  SCVFont *font = scvGetFont(&b->gl, b->font);
+  u64 i;
+  f32 y;
+
+  (void)frame;
+  for (i = 0; i < 200; ++i) {
+    y = (f32)(i % 44) * 18.0f;
+    scvAssert(scvGLDrawAtlasImage(&b->gl, (SCVRect){ .origin = { 2.0f, y }, .size = { 16.0f, 16.0f } },
+        (SCVColor){ 255, 255, 255, 255 }, b->avatars[i % 4]));
+    scvGLDrawRect(&b->gl, (SCVRect){ .origin = { 22.0f, y }, .size = { 6.0f, 16.0f } },
+        (SCVColor){ 200, 40, 40, 255 });
+    scvDrawText(&b->gl, (SCVColor){ 20, 20, 20, 255 }, font,
+        (SCVPoint){ 32.0f, y }, line);
+  }
+}
+
+// labels over images (own texture, not atlas) in a grid, image goes to
+// lower layer, label and its backdrop to upper one
+void
+BenchGLSceneOverlay(BenchGLState *b, u64 frame)
+{
+  SCVString label = scvUnsafeCString("img_042");
+  SCVFont *font = scvGetFont(&b->gl, b->font);
+  u64 i;
+  f32 x, y;
+
+  (void)frame;
+  for (i = 0; i < 300; ++i) {
+    x = (f32)(i % 20) * 64.0f;
+    y = (f32)(i / 20) * 52.0f;
+    scvGLSetLayer(&b->gl, 0);
+    scvGLDrawImage(&b->gl, (SCVRect){ .origin = { x, y }, .size = { 60.0f, 48.0f } },
+        (SCVColor){ 255, 255, 255, 255 }, b->image);
+    scvGLSetLayer(&b->gl, 1);
+    scvGLDrawRect(&b->gl, (SCVRect){ .origin = { x, y + 30.0f }, .size = { 60.0f, 18.0f } },
+        (SCVColor){ 0, 0, 0, 160 });
+    scvDrawText(&b->gl, (SCVColor){ 255, 255, 255, 255 }, font,
+        (SCVPoint){ x + 2.0f, y + 30.0f }, label);
+  }
+}
+
+// cards without layers: backdrop rect, image over it, badge rect on top.
+// Badge has backdrop's state but must stay over image, while backdrops of
+// next cards don't overlap and can join it
+void
+BenchGLSceneStacked(BenchGLState *b, u64 frame)
+{
+  u64 i;
+  f32 x, y;
+
+  (void)frame;
+  for (i = 0; i < 300; ++i) {
+    x = (f32)(i % 20) * 64.0f;
+    y = (f32)(i / 20) * 52.0f;
+    scvGLDrawRect(&b->gl, (SCVRect){ .origin = { x, y }, .size = { 60.0f, 48.0f } },
+        (SCVColor){ 40, 40, 200, 255 });
+    scvGLDrawImage(&b->gl, (SCVRect){ .origin = { x + 4.0f, y + 4.0f }, .size = { 52.0f, 40.0f } },
+        (SCVColor){ 255, 255, 255, 255 }, b->image);
+    scvGLDrawRect(&b->gl, (SCVRect){ .origin = { x + 24.0f, y + 18.0f }, .size = { 12.0f, 12.0f } },
+        (SCVColor){ 0, 255, 0, 255 });
+  }
+}
+
+// returns hash of last frame pixels
+u64
+BenchGLRun(BenchGLState *b, char *name, BenchGLScene scene, char *dump)
+{
+  SCVTimer timer = {0};
+  SCVTimer sceneTimer = {0};
+  u64 i, record = 0, submit = 0, total = 0, t, r;
+  u64 hash;
+  char label[128];
+  i32 fd;
+  SCVError error = {0};
+
+  scvInitTimer(&timer);
+  scvInitTimer(&sceneTimer);
+  for (i = 0; i < BENCH_GL_FRAMES + 3; ++i) {
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glFinish();
+
+    scvTimerTic(&timer);
+    scvGLBegin(&b->gl);
+    scvTimerTic(&sceneTimer);
+    scene(b, i);
+    r = scvTimerToc(&sceneTimer, SCV_NS);
+    scvGLEnd(&b->gl);
+    t = scvTimerToc(&timer, SCV_NS);
+    glFinish();
+    if (i >= 3) {
+      record += r;
+      submit += t;
+      total += scvTimerToc(&timer, SCV_NS);
+    }
+  }
+
+  // vertex path flushes mid frame when vertex buffer fills, that is in record
+  snprintf(label, sizeof(label), "gl %s, record per frame", name);
+  BenchReport(label, BENCH_GL_FRAMES, record);
+  snprintf(label, sizeof(label), "gl %s, submit per frame", name);
+  BenchReport(label, BENCH_GL_FRAMES, submit);
+  snprintf(label, sizeof(label), "gl %s, frame with glFinish", name);
+  BenchReport(label, BENCH_GL_FRAMES, total);
+
+  snprintf(label, sizeof(label), "gl %s, per frame: %llu flushes, %llu draws, %llu binds, %llu uploads, %llu bytes",
+      name, (unsigned long long)b->gl.Stats.flushes, (unsigned long long)b->gl.Stats.drawcalls,
+      (unsigned long long)b->gl.Stats.binds,
+      (unsigned long long)b->gl.Stats.uploads, (unsigned long long)b->gl.Stats.uploadBytes);
+  scvPrintCString(label);
+  if (b->gl.Stats.glyphHits + b->gl.Stats.glyphMisses) {
+    snprintf(label, sizeof(label), "gl %s, glyphs per frame: %llu hits, %llu misses, %llu evictions, %llu atlas updates",
+        name, (unsigned long long)b->gl.Stats.glyphHits, (unsigned long long)b->gl.Stats.glyphMisses,
+        (unsigned long long)b->gl.Stats.glyphEvictions, (unsigned long long)b->gl.Stats.atlasUploads);
+    scvPrintCString(label);
+  }
+
+  glReadPixels(0, 0, BENCH_GL_WIDTH, BENCH_GL_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, b->pixels);
+  hash = scvHashBytes(b->pixels, BENCH_GL_WIDTH * BENCH_GL_HEIGHT * 3, 0);
+  snprintf(label, sizeof(label), "gl %s, pixels hash %016llx", name, (unsigned long long)hash);
+  scvPrintCString(label);
+
+  if (dump) {
+    // binary ppm, rows bottom up as gl reads them
+    snprintf(label, sizeof(label), "%s_%s.ppm", dump, name);
+    fd = scvOpenat(AT_FDCWD, scvUnsafeCString(label), O_WRONLY | O_CREAT | O_TRUNC, 0644, &error);
+    scvAssert(error.tag == 0);
+    snprintf(label, sizeof(label), "P6\n%d %d\n255\n", BENCH_GL_WIDTH, BENCH_GL_HEIGHT);
+    scvWrite(fd, label, strlen(label), &error);
+    for (i = BENCH_GL_HEIGHT; i > 0; --i) {
+      scvWrite(fd, b->pixels + (i - 1) * BENCH_GL_WIDTH * 3, BENCH_GL_WIDTH * 3, &error);
+    }
+    scvClose(fd);
+  }
+
+  return hash;
+}
+
+// text over two plain textures, glyphs of every line spread over few small
+// glyph pages, so sorting has to keep drawcalls of different pages apart
+void
+BenchGLScenePages(BenchGLState *b, u64 frame)
+{
+  SCVString line = scvUnsafeCString("I/ReactNativeJS: fetch done абвгдеёжзиклмнопрст {\"id\": 42}");
+  SCVFont *font = scvGetFont(&b->gl, b->font);
+  u64 i;
+  f32 y;
+
+  (void)frame;
+  for (i = 0; i < 100; ++i) {
+    y = (f32)(i % 44) * 18.0f;
+    scvGLDrawImage(&b->gl, (SCVRect){ .origin = { 2.0f, y }, .size = { 16.0f, 16.0f } },
+        (SCVColor){ 255, 255, 255, 255 }, b->image);
+    scvDrawText(&b->gl, (SCVColor){ 20, 20, 20, 255 }, font, (SCVPoint){ 22.0f, y }, line);
+    scvGLDrawImage(&b->gl, (SCVRect){ .origin = { 640.0f, y }, .size = { 16.0f, 16.0f } },
+        (SCVColor){ 40, 40, 200, 255 }, b->gl.DefaultTextureId);
+    scvDrawText(&b->gl, (SCVColor){ 200, 40, 40, 255 }, font, (SCVPoint){ 660.0f, y }, line);
+  }
+}
+
+// context with 64px atlas pages, glyphs of one frame take several of them
+void
+BenchGLGlyphPages(BenchGLState *b, char *dump)
+{
+  u64 sorted;
+  u32 i, pages = 0;
+
+  scvGLCtxInit(&b->gl, &((SCVGLCtxDesc){
+    .arena       = &b->arena,
+    .scaleFactor = 1.0f,
+    .viewport    = { .size = { BENCH_GL_WIDTH, BENCH_GL_HEIGHT } },
+    .atlassize   = 64,
+    .atlaspages  = 16,
+  }));
+  b->font = scvFontInit(&b->gl, &b->arena, &((SCVFontDesc){
+    .fontsize = 16.0f,
+    .fontpath = scvUnsafeCString("./assets/3270-Regular.ttf"),
+  }));
+
+  sorted = BenchGLRun(b, "glyph-pages", BenchGLScenePages, dump);
+  for (i = 0; i < b->gl.Atlas.pagesLen; ++i) {
+    pages += b->gl.Atlas.pages[i].glyphs ? 1 : 0;
+  }
+  scvAssert(pages > 1 && b->gl.Atlas.evictions == 0);
+
+  b->gl.DrawSort = SCV_GL_SORT_NONE;
+  scvAssert(BenchGLRun(b, "glyph-pages-unsorted", BenchGLScenePages, dump) == sorted);
+  b->gl.DrawSort = SCV_GL_SORT_LAYERS;
+  scvAssert(glGetError() == GL_NO_ERROR);
+}
+
+// 64px pages, three of them, 24px images: fills atlas, checks which page
+// is dropped, that entries of dropped page go stale and pinned ones stay
+void
+BenchGLAtlasEviction(BenchGLState *b)
+{
+  u8 texels[24 * 24 * 4];
+  SCVImage image = {0};
+  SCVHandle handles[64];
+  u32 pages[64];
+  SCVHandle pinned, first = SCV_HANDLE_NIL, handle;
+  SCVAtlas *atlas = &b->gl.Atlas;
+  SCVRect rect = { .size = { 24.0f, 24.0f } };
+  SCVColor white = { 255, 255, 255, 255 };
+  u64 evictions;
+  u32 i, j, n = 0;
+
+  scvGLCtxInit(&b->gl, &((SCVGLCtxDesc){
+    .arena       = &b->arena,
+    .scaleFactor = 1.0f,
+    .viewport    = { .size = { BENCH_GL_WIDTH, BENCH_GL_HEIGHT } },
+    .atlassize   = 64,
+    .atlaspages  = 3,
+  }));
+  memset(texels, 200, sizeof(texels));
+  image.data = texels;
+  image.width = image.height = 24;
+  image.mipmapcount = 1;
+  image.pixelformat = SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+  scvGLBegin(&b->gl);
+  pinned = scvAtlasAdd(&b->gl, image, SCV_ATLAS_PINNED);
+  scvAssert(pinned != SCV_HANDLE_NIL);
+  scvGLEnd(&b->gl);
+
+  // one add per frame, page of the first unpinned entry is drawn every
+  // frame, so the other unpinned page is least recently used
+  while (atlas->evictions == 0) {
+    scvGLBegin(&b->gl);
+    if (first != SCV_HANDLE_NIL) {
+      scvAssert(scvGLDrawAtlasImage(&b->gl, rect, white, first));
+    }
+    scvAssert(n < 64);
+    handles[n] = scvAtlasAdd(&b->gl, image, 0);
+    scvAssert(handles[n] != SCV_HANDLE_NIL);
+    pages[n] = scvAtlasGet(&b->gl, handles[n])->page;
+    if (first == SCV_HANDLE_NIL && pages[n] != scvAtlasGet(&b->gl, pinned)->page) {
+      first = handles[n];
+    }
+    n++;
+    scvGLEnd(&b->gl);
+  }
+  scvAssert(atlas->pagesLen == 3 && b->gl.Stats.flushes == 1);
+  j = scvAtlasGet(&b->gl, handles[n - 1])->page;
+  scvAssert(j != scvAtlasGet(&b->gl, pinned)->page && j != scvAtlasGet(&b->gl, first)->page);
+  for (i = 0; i + 1 < n; ++i) {
+    scvAssert((scvAtlasGet(&b->gl, handles[i]) == nil) == (pages[i] == j));
+  }
+
+  // both unpinned pages drawn in this frame, dropping one flushes first
+  evictions = atlas->evictions;
+  scvGLBegin(&b->gl);
+  scvAssert(scvGLDrawAtlasImage(&b->gl, rect, white, first));
+  scvAssert(scvGLDrawAtlasImage(&b->gl, rect, white, handles[n - 1]));
+  for (i = 0; atlas->evictions == evictions; ++i) {
+    scvAssert(i < 64);
+    handle = scvAtlasAdd(&b->gl, image, 0);
+    scvAssert(handle != SCV_HANDLE_NIL);
+  }
+  scvAssert(b->gl.Stats.flushes == 1);
+  scvGLEnd(&b->gl);
+  for (i = 0; i < n; ++i) {
+    if (scvAtlasGet(&b->gl, handles[i])) {
+      continue;
+    }
+    scvGLBegin(&b->gl);
+    scvAssert(!scvGLDrawAtlasImage(&b->gl, rect, white, handles[i]));
+    scvGLEnd(&b->gl);
+  }
+
+  // pinned entries spread over every page, then nothing can be dropped
+  for (i = 0; i < 64; ++i) {
+    scvGLBegin(&b->gl);
+    handle = scvAtlasAdd(&b->gl, image, SCV_ATLAS_PINNED);
+    scvGLEnd(&b->gl);
+    if (handle == SCV_HANDLE_NIL) {
+      break;
+    }
+  }
+  scvAssert(handle == SCV_HANDLE_NIL);
+  for (i = 0; i < atlas->pagesLen; ++i) {
+    scvAssert(atlas->pages[i].pinned > 0);
+  }
+  scvAssert(scvAtlasGet(&b->gl, pinned) != nil);
+  scvAssert(glGetError() == GL_NO_ERROR);
+  scvPrint("gl atlas evictions: ");
+  scvPrintU64(atlas->evictions);
+}
+
+// frames back to back without glFinish between them, the way they go to
+// display, so GPU may still read previous frame while next one is written
+void
+BenchGLStreamMode(BenchGLState *b, char *name, u32 mode, BenchGLScene scene)
+{
+  SCVTimer timer = {0};
+  SCVGLStream *streams[2] = { &b->gl.VertexStream, &b->gl.IndexStream };
+  u64 i, total;
+  char label[128];
+
+  for (i = 0; i < 2; ++i) {
+    glBindBuffer(streams[i]->target, streams[i]->buffer);
+    scvGLStreamReset(streams[i], 0);
+    streams[i]->mode = mode;
+    streams[i]->waits = 0;
+  }
+
+  glFinish();
+  scvInitTimer(&timer);
+  scvTimerTic(&timer);
+  for (i = 0; i < BENCH_GL_FRAMES * 4; ++i) {
+    glClear(GL_COLOR_BUFFER_BIT);
+    scvGLBegin(&b->gl);
+    scene(b, i);
+    scvGLEnd(&b->gl);
+  }
+  glFinish();
+  total = scvTimerToc(&timer, SCV_NS);
+
+  snprintf(label, sizeof(label), "gl stream %s, pipelined frame", name);
+  BenchReport(label, BENCH_GL_FRAMES * 4, total);
+  snprintf(label, sizeof(label), "gl stream %s, fence waits %llu", name,
+      (unsigned long long)(streams[0]->waits + streams[1]->waits));
+  scvPrintCString(label);
+}
+
+// write which skips to wrap needs more than ring retired so far, after
+// everything in flight is done it has to go without waiting
+void
+BenchGLStreamWrap(void)
+{
+  SCVGLStream stream;
+  SCVGLStats stats = {0};
+  u8 *data;
+  u32 buffer;
+  u64 offset;
+  SCVArenaTemp scratch = scvScratchBegin(nil, 0);
+
+  data = scvArenaAlloc(scratch.arena, 45000);
+  glGenBuffers(1, &buffer);
+  scvGLStreamInit(&stream, buffer, GL_ARRAY_BUFFER, SCV_GL_STREAM_MAP, 65536);
+  scvGLStreamWrite(&stream, data, 40000, 4, &stats);
+  scvGLStreamFence(&stream);
+  glFinish();
+  offset = scvGLStreamWrite(&stream, data, 45000, 4, &stats);
+  scvAssert(offset == 0 && stream.fenceHead == stream.fenceTail);
+  scvGLStreamFence(&stream);
+  scvGLStreamReset(&stream, 0);
+  glDeleteBuffers(1, &buffer);
+  scvAssert(glGetError() == GL_NO_ERROR);
+  scvScratchEnd(scratch);
+}
+
+void
+BenchGL(char *dump)
+{
+  BenchGLState b = {0};
+  SCVError error = {0};
+  SCVImage image = {0};
+  SCVImage quarter;
+  SCVTimer timer = {0};
+  int width, height, comp;
+  u64 mixed, overlay, stacked;
+  u8 center[3];
+  u32 i;
+
+  BenchGLInitContext();
+  scvAssert(glGetError() == GL_NO_ERROR);
+  scvArenaInit(&b.arena, &error);
+  scvAssert(error.tag == 0);
+
+  glGenFramebuffers(1, &b.fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, b.fbo);
+  glGenRenderbuffers(1, &b.target);
+  glBindRenderbuffer(GL_RENDERBUFFER, b.target);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, BENCH_GL_WIDTH, BENCH_GL_HEIGHT);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, b.target);
+  scvAssert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  b.pixels = scvArenaAlloc(&b.arena, BENCH_GL_WIDTH * BENCH_GL_HEIGHT * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+  scvGLCtxInit(&b.gl, &((SCVGLCtxDesc){
+    .arena       = &b.arena,
+    .scaleFactor = 1.0f,
+    .viewport    = { .size = { BENCH_GL_WIDTH, BENCH_GL_HEIGHT } },
+  }));
+  scvAssert(glGetError() == GL_NO_ERROR);
+  scvInitTimer(&timer);
+  scvTimerTic(&timer);
+  b.font = scvFontInit(&b.gl, &b.arena, &((SCVFontDesc){
+    .fontsize = 16.0f,
+    .fontpath = scvUnsafeCString("./assets/3270-Regular.ttf"),
+  }));
+  BenchReport("gl font init", 1, scvTimerToc(&timer, SCV_NS));
+  scvAssert(scvFontInit(&b.gl, &b.arena, &((SCVFontDesc){
+    .fontsize = 16.0f,
+    .fontpath = scvUnsafeCString("/nonexistent/scv.ttf"),
+  })) == SCV_HANDLE_NIL);
+  scvAssert(scvFontInit(&b.gl, &b.arena, &((SCVFontDesc){
+    .fontsize = 16.0f,
+    .fontdata = scvUnsafeString(scvArenaAlloc(&b.arena, 4096), 4096),
+  })) == SCV_HANDLE_NIL);
+
+  image.data = stbi_load("scv.jpg", &width, &height, &comp, 4);
+  scvAssert(image.data);
+  image.width = (u32)width;
+  image.height = (u32)height;
+  image.mipmapcount = 1;
+  image.pixelformat = SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  b.image = scvGLLoadTexture(image);
+  image.pitch = image.width * 4;
+  image.width /= 2;
+  image.height /= 2;
+  for (i = 0; i < 4; ++i) {
+    quarter = image;
+    quarter.data = (u8 *)image.data + (i / 2) * image.height * image.pitch + (i % 2) * image.width * 4;
+    b.avatars[i] = scvAtlasAdd(&b.gl, quarter, 0);
+    scvAssert(b.avatars[i] != SCV_HANDLE_NIL);
+  }
+  stbi_image_free(image.data);
+  scvAssert(glGetError() == GL_NO_ERROR);
+
+  BenchGLRun(&b, "rects", BenchGLSceneRects, dump);
+  BenchGLRun(&b, "text", BenchGLSceneText, dump);
+  BenchGLRun(&b, "unicode", BenchGLSceneUnicode, dump);
+  mixed = BenchGLRun(&b, "mixed", BenchGLSceneMixed, dump);
+  BenchGLRun(&b, "atlas", BenchGLSceneAtlas, dump);
+  overlay = BenchGLRun(&b, "overlay", BenchGLSceneOverlay, dump);
+  stacked = BenchGLRun(&b, "stacked", BenchGLSceneStacked, dump);
+  // badge of first card, rows are bottom up
+  glReadPixels(30, BENCH_GL_HEIGHT - 1 - 24, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, center);
+  scvAssert(center[0] == 0 && center[1] == 255 && center[2] == 0);
+  scvAssert(glGetError() == GL_NO_ERROR);
+
+  // submission order, pixels have to match sorted runs
+  b.gl.DrawSort = SCV_GL_SORT_NONE;
+  scvAssert(BenchGLRun(&b, "mixed-unsorted", BenchGLSceneMixed, dump) == mixed);
+  scvAssert(BenchGLRun(&b, "overlay-unsorted", BenchGLSceneOverlay, dump) == overlay);
+  scvAssert(BenchGLRun(&b, "stacked-unsorted", BenchGLSceneStacked, dump) == stacked);
+  b.gl.DrawSort = SCV_GL_SORT_LAYERS;
+
+  // same scenes through 4 vertices + 6 indices per quad
+  b.gl.QuadMode = SCV_GL_QUAD_VERTICES;
+  BenchGLRun(&b, "rects-vertices", BenchGLSceneRects, dump);
+  BenchGLRun(&b, "text-vertices", BenchGLSceneText, dump);
+  BenchGLRun(&b, "mixed-vertices", BenchGLSceneMixed, dump);
+  scvAssert(BenchGLRun(&b, "stacked-vertices", BenchGLSceneStacked, dump) == stacked);
+  b.gl.QuadMode = SCV_GL_QUAD_INSTANCED;
+  scvAssert(glGetError() == GL_NO_ERROR);
+
+  BenchGLStreamMode(&b, "subdata", SCV_GL_STREAM_SUBDATA, BenchGLSceneMixed);
+  BenchGLStreamMode(&b, "orphan", SCV_GL_STREAM_ORPHAN, BenchGLSceneMixed);
+  BenchGLStreamMode(&b, "map", SCV_GL_STREAM_MAP, BenchGLSceneMixed);
+  BenchGLStreamWrap();
+  scvAssert(glGetError() == GL_NO_ERROR);
+
+  // replace context and font, go last
+  BenchGLGlyphPages(&b, dump);
+  BenchGLAtlasEviction(&b);
+
+  scvArenaRelease(&b.arena);
+}
+
+#endif
+
+int
+main(int argc, char **argv)
+{
+  SCVTimer timer = {0};
+  scvInitTimer(&timer);
+  scvPrint("timer freq hz: ");
+  scvPrintU64(timer.freq);
+
+#ifdef SCV_GL_BENCH
+  // renderer only, core benches run in plain build
+  BenchGL(argc > 1 ? argv[1] : nil);
+  return 0;
+#else
+  unused(argc);
+  unused(argv);
+#endif
+
+  BenchTimer();
+  BenchArena();
+  BenchPool();
+  BenchSlabPool();
+  BenchSlabPoolContended();
+  BenchUTF8();
+  BenchLog();
+  BenchWriter();
+  BenchFiles();
+  BenchMap();
+  BenchSearch();
+  BenchProfile();
+  BenchJobs();
+  BenchIO();
+  BenchArray();
+  BenchLoop();
+
+  return 0;
+}
+
+SCVSyscallResult
+scvSyscallResult(i64 ret)
+{
+  SCVSyscallResult r;
+
+  // NOTE: linux returns -errno in [-4095, -1] instead of setting carry flag
+  if ((u64)ret > (u64)-4096) {
+    r.r1  = (uptr)-1;
+    r.r2  = 0;
+    r.err = (uptr)-ret;
+  } else {
+    r.r1  = (uptr)ret;
+    r.r2  = 0;
+    r.err = 0;
+  }
+
+  return r;
+}
+
+#if defined(__x86_64__)
+
+SCVSyscallResult
+scvSyscall(uptr trap, uptr a1, uptr a2, uptr a3)
+{
+  i64 ret;
+
+  __asm__ __volatile__(
+    "syscall\n"
+    :
+    "=a"(ret)
+    :
+    "a"(trap), "D"(a1), "S"(a2), "d"(a3)
+    :
+    "rcx", "r11", "memory"
+  );
+
+  return scvSyscallResult(ret);
+}
+
+SCVSyscallResult
+scvSyscall6(uptr trap, uptr a1, uptr a2, uptr a3, uptr a4, uptr a5, uptr a6)
+{
+  i64 ret;
+  register uptr r10 __asm__("r10") = a4;
+  register uptr r8  __asm__("r8")  = a5;
+  register uptr r9  __asm__("r9")  = a6;
+
+  __asm__ __volatile__(
+    "syscall\n"
+    :
+    "=a"(ret)
+    :
+    "a"(trap), "D"(a1), "S"(a2), "d"(a3), "r"(r10), "r"(r8), "r"(r9)
+    :
+    "rcx", "r11", "memory"
+  );
+
+  return scvSyscallResult(ret);
+}
+
+#elif defined(__aarch64__)
+
+SCVSyscallResult
+scvSyscall(uptr trap, uptr a1, uptr a2, uptr a3)
+{
+  register uptr x8 __asm__("x8") = trap;
+  register uptr x0 __asm__("x0") = a1;
+  register uptr x1 __asm__("x1") = a2;
+  register uptr x2 __asm__("x2") = a3;
+
+  __asm__ __volatile__(
+    "svc #0\n"
+    :
+    "+r"(x0)
+    :
+    "r"(x8), "r"(x1), "r"(x2)
+    :
+    "memory"
+  );
+
+  return scvSyscallResult((i64)x0);
+}
+
+SCVSyscallResult
+scvSyscall6(uptr trap, uptr a1, uptr a2, uptr a3, uptr a4, uptr a5, uptr a6)
+{
+  register uptr x8 __asm__("x8") = trap;
+  register uptr x0 __asm__("x0") = a1;
+  register uptr x1 __asm__("x1") = a2;
+  register uptr x2 __asm__("x2") = a3;
+  register uptr x3 __asm__("x3") = a4;
+  register uptr x4 __asm__("x4") = a5;
+  register uptr x5 __asm__("x5") = a6;
+
+  __asm__ __volatile__(
+    "svc #0\n"
+    :
+    "+r"(x0)
+    :
+    "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), "r"(x5)
+    :
+    "memory"
+  );
+
+  return scvSyscallResult((i64)x0);
+}
+
+#else
+#error "unsupported linux architecture"
+#endif
@@ -8,9 +8,13 @@
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/event.h>
+#include <sys/sysctl.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <math.h>
 #include <string.h>
+#include <pthread.h>
+#include <sched.h>
 #include <Cocoa/Cocoa.h>
 #include <CoreVideo/CVDisplayLink.h>
 #include <objc/runtime.h>
@@ -38,6 +42,39 @@ bool isRunning = true;
 NSApplication *NSApp;
 NSWindow *win;
 
+// display link runs only while app has something to draw
+CVDisplayLinkRef displayLink;
+bool displayLinkRunning = false;
+
+enum AppEventType {
+  APP_EVENT_WAKE = 1,
+  APP_EVENT_IDLE,
+};
+
+void
+PostAppEvent (short subtype)
+{
+  @autoreleasepool {
+    NSEvent *event = [NSEvent otherEventWithType:NSEventTypeApplicationDefined
+                                        location:NSZeroPoint
+                                   modifierFlags:0
+                                       timestamp:0
+                                    windowNumber:0
+                                         context:nil
+                                         subtype:subtype
+                                           data1:0
+                                           data2:0];
+    [NSApp postEvent:event atStart:NO];
+  }
+}
+
+void
+WakeMainThread (void *data)
+{
+  unused (data);
+  PostAppEvent (APP_EVENT_WAKE);
+}
+
 CVReturn
 DisplayCallback (CVDisplayLinkRef displayLink, const CVTimeStamp *inNow,
                  const CVTimeStamp *inOutputTime, CVOptionFlags flagsIn,
@@ -59,9 +96,14 @@ DisplayCallback (CVDisplayLinkRef displayLink, const CVTimeStamp *inNow,
 
   [context makeCurrentContext];
   [context lock];
-  AppUpdate(&GlobalContext);
-
-  [context flushBuffer];
+  if (AppUpdate(&GlobalContext))
+    {
+      [context flushBuffer];
+    }
+  else
+    {
+      PostAppEvent (APP_EVENT_IDLE);
+    }
   [context unlock];
   return kCVReturnSuccess;
 }
@@ -143,7 +185,6 @@ main (void)
                     defer:NO];
   [win setTitle:@"Basic title"];
 
-  CVDisplayLinkRef displayLink;
   NSOpenGLPixelFormat *format =
       [[NSOpenGLPixelFormat alloc] initWithAttributes:attribues];
   NSOpenGLView *view =
@@ -161,6 +202,7 @@ main (void)
       .origin = { rect.origin.x, rect.origin.y },
       .size   = { rect.size.width, rect.size.height }
   }, (f32)([NSScreen mainScreen].backingScaleFactor));
+  AppSetWake(&GlobalContext, WakeMainThread, nil);
 
   CGDirectDisplayID displayID = CGMainDisplayID();
   CVDisplayLinkCreateWithCGDisplay(displayID, &displayLink);
@@ -175,13 +217,30 @@ main (void)
   [win makeMainWindow];
   [NSApp finishLaunching];
 
-  CVDisplayLinkStart (displayLink);
   while (isRunning)
     {
+      if (AppNeedsUpdate (&GlobalContext) && !displayLinkRunning)
+        {
+          CVDisplayLinkStart (displayLink);
+          displayLinkRunning = true;
+        }
+
       NSEvent *event = [NSApp nextEventMatchingMask:NSEventMaskAny
-                                          untilDate:[NSDate distantPast]
+                                          untilDate:[NSDate distantFuture]
                                              inMode:NSDefaultRunLoopMode
                                             dequeue:YES];
+      if (event.type == NSEventTypeApplicationDefined)
+        {
+          // stop and then check dirty again (loop top), so invalidate
+          // which raced with idle frame still gets drawn
+          if (event.subtype == APP_EVENT_IDLE && displayLinkRunning)
+            {
+              CVDisplayLinkStop (displayLink);
+              displayLinkRunning = false;
+            }
+          continue;
+        }
+
       if (event.type == NSEventTypeKeyDown && event.keyCode == 12
           && (event.modifierFlags & NSEventModifierFlagCommand)
                  == NSEventModifierFlagCommand)
@@ -191,10 +250,15 @@ main (void)
 
       [NSApp sendEvent:event];
       [NSApp updateWindows];
+      AppInvalidate (&GlobalContext);
     }
 
-  CVDisplayLinkStop (displayLink);
+  if (displayLinkRunning)
+    {
+      CVDisplayLinkStop (displayLink);
+    }
   CVDisplayLinkRelease (displayLink);
+  scvLogStop();
   [view release];
   [NSApp terminate:nil];
 
@@ -202,75 +266,6 @@ main (void)
   }
 }
 
-void 
-scvLog(
-    char *tag,
-    enum SCVLogLevel level,
-    u32 logitem,
-    char* msg,
-    u32 line,
-    char* filename
-) {
-  SCVString loglvlstr;
-  u8 linebuf[1024];
-  u32 n = 0;
-
-  SCVSlice s = scvUnsafeSlice(linebuf, sizeof(linebuf));
-
-  switch (level) {
-    case SCV_LOG_PANIC:
-      loglvlstr = scvUnsafeCString("panic"); break;
-    case SCV_LOG_ERROR:
-      loglvlstr = scvUnsafeCString("error"); break;
-    case SCV_LOG_WARN:
-      loglvlstr = scvUnsafeCString("warn"); break;
-    default:
-      loglvlstr = scvUnsafeCString("info"); break;
-  }
-
-  n += scvSlicePutCString(scvSliceLeft(s, n), "[");
-  n += scvSlicePutCString(scvSliceLeft(s, n), tag);
-  n += scvSlicePutCString(scvSliceLeft(s, n), "]");
-
-  n += scvSlicePutCString(scvSliceLeft(s, n), "[");
-  n += scvSlicePutString(scvSliceLeft(s, n),  loglvlstr);
-  n += scvSlicePutCString(scvSliceLeft(s, n), "]");
-
-  if (logitem > 0) {
-    n += scvSlicePutCString(scvSliceLeft(s, n), "[id:");
-    n += scvSlicePutU64(scvSliceLeft(s, n), (u64)logitem);
-    n += scvSlicePutCString(scvSliceLeft(s, n), "]");
-  }
-
-  if (filename) {
-    // gcc/clang compiler error format
-    n += scvSlicePutCString(scvSliceLeft(s, n), " ");
-    n += scvSlicePutCString(scvSliceLeft(s, n), filename);
-    n += scvSlicePutCString(scvSliceLeft(s, n), ":");
-    n += scvSlicePutU64(scvSliceLeft(s, n), (u64)line);
-    n += scvSlicePutCString(scvSliceLeft(s, n), ":0:");
-  } else {
-    n += scvSlicePutCString(scvSliceLeft(s, n), "[line:");
-    n += scvSlicePutU64(scvSliceLeft(s, n), (u64)line);
-    n += scvSlicePutCString(scvSliceLeft(s, n), "]");
-  }
-
-  if (msg) {
-    n += scvSlicePutCString(scvSliceLeft(s, n), "\n\t");
-    n += scvSlicePutCString(scvSliceLeft(s, n), msg);    
-  }
-  n += scvSlicePutCString(scvSliceLeft(s, n), "\n\n");
-
-  if (level == SCV_LOG_PANIC) {
-    n += scvSlicePutCString(scvSliceLeft(s, n), "ABORTING because of [panic]\n");
-  }
-  scvPrintString(scvString(scvSliceRight(s, n)));
-
-  if (level == SCV_LOG_PANIC) {
-    scvBreakpoint;
-  }
-}
-
 SCVSyscallResult
 scvSyscall(uptr trap, uptr a1, uptr a2, uptr a3)
 {
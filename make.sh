@@ -17,12 +17,22 @@ LDFLAGS=""
 SRC=macos_app.m
 FSANITITZE="-fsanitize=address"
 
+LINUX_CFLAGS="-Wall -Wextra -Wpedantic -Werror -std=c99 -D_DEFAULT_SOURCE"
+LINUX_SRC=linux_app.c
+
 case $1 in
   'build')
     rm -fr $BUNDLE
     mkdir $BUNDLE
     clang -o "$BUNDLE/$PROJECT" -g -O0 $OBJCFLAGS  $FRAMEWORKS $LDFLAGS  $SRC
     ;;
+  'build-linux')
+    cc -o "$PROJECT" -g -O2 $LINUX_CFLAGS $LINUX_SRC -lpthread
+    ;;
+  'build-linux-gl')
+    # headless renderer benchmark, needs EGL (mesa surfaceless is enough)
+    cc -o "${PROJECT}GL" -g -O2 $LINUX_CFLAGS -DSCV_GL_BENCH $LINUX_SRC -lpthread -lEGL -lGL -lm
+    ;;
   'fmt')
       for file in $SRC_FILES; do
         echo $file
@@ -33,4 +43,10 @@ case $1 in
   'run')
     ./${BUNDLE}/${PROJECT}
     ;;
+  'run-linux')
+    ./${PROJECT}
+    ;;
+  'run-linux-gl')
+    ./${PROJECT}GL
+    ;;
 esac
@@ -5,7 +5,13 @@
  * headers needed: 
  * <stdint.h> - uint8_t, uptr_t, uint16_t...
  * <stdbool.h> - true/false, bool
- * <string.h> - memcpy, memmove, strlen, strncmp, memset
+ * <string.h> - memcpy, memmove, memcmp, strlen, memset
+ * <sys/syscall.h>, <sys/mman.h>, <sys/stat.h>, <fcntl.h> - syscall numbers and flags
+ *   (MAP_POPULATE, POSIX_FADV_* need _DEFAULT_SOURCE on linux)
+ * <time.h> - struct timespec, CLOCK_MONOTONIC (linux x86_64 timer)
+ * <pthread.h>, <sched.h> - threads for background log writer
+ * <linux/io_uring.h>, <errno.h> - async io (linux only)
+ * <sys/epoll.h> - event loop (linux only)
  *
  */
 
@@ -13,6 +19,12 @@
 #define nil (void *)0
 #endif
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 typedef int8_t	i8;
 typedef uint8_t	u8;
 typedef uint8_t	byte;
@@ -32,11 +44,16 @@ typedef double	f64;
 typedef uintptr_t	uptr;
 
 enum SCVErrorType {
-  SCV_UTF8_INCORRECT_ENDCODING,
+  SCV_UTF8_INCORRECT_ENDCODING = 1, // 0 tag means no error
   SCV_UTF8_SURROGATE_HALF_FOUND,
+  SCV_ARENA_OUT_OF_RESERVE,
 };
 
+#if defined(__clang__)
 #define scvBreakpoint __builtin_debugtrap()
+#else
+#define scvBreakpoint __builtin_trap()
+#endif
 #define scvMin(a, b) ((a) < (b) ? (a) : (b))
 #define scvMax(a, b) ((a) > (b) ? (a) : (b))
 #define scvAssert(expr)                         \
@@ -47,13 +64,44 @@ enum SCVErrorType {
   } while (0)
 #define SCV_ERRBUF_SIZE 1024
 
+#ifndef SCV_PAGE_SIZE
+#define SCV_PAGE_SIZE 4096
+#endif
+
 #ifndef SCV_DEFAULT_ALIGNMENT
 #define SCV_DEFAULT_ALIGNMENT (2*sizeof(void *))
 #endif
 
+#define scvThreadLocal __thread
+
+// atomics, gcc/clang builtins
+#define scvAtomicLoad(p)               __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define scvAtomicLoadRelaxed(p)        __atomic_load_n((p), __ATOMIC_RELAXED)
+#define scvAtomicStore(p, v)           __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define scvAtomicStoreRelaxed(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define scvAtomicAdd(p, v)             __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#define scvAtomicAddRelaxed(p, v)      __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define scvAtomicCAS(p, expected, v)   \
+  __atomic_compare_exchange_n((p), (expected), (v), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define scvAtomicCASStrong(p, expected, v) \
+  __atomic_compare_exchange_n((p), (expected), (v), false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)
+#define scvAtomicExchange(p, v)        __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#define scvAtomicFence()               __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define scvCacheLineSize 64
+
 #define scvIsPowerOfTwo(x) (((x) & ((x) - 1)) == 0)
 #define scvArenaAllocErr(a, size, e) scvArenaAllocAlign(a, size, e, SCV_DEFAULT_ALIGNMENT)
 #define scvArenaAlloc(a, size) scvArenaAllocAlign(a, size, nil, SCV_DEFAULT_ALIGNMENT)
+// for memory which caller fully overwrites right away (vertexes, bitmaps)
+#define scvArenaAllocNoZero(a, size) scvArenaAllocAlignNoZero(a, size, nil, SCV_DEFAULT_ALIGNMENT)
+
+#ifndef SCV_ARENA_DEFAULT_RESERVE
+#define SCV_ARENA_DEFAULT_RESERVE (64ull << 30)
+#endif
+
+#ifndef SCV_ARENA_COMMIT_SIZE
+#define SCV_ARENA_COMMIT_SIZE (64 * 1024)
+#endif
 
 typedef struct SCVError SCVError;
 typedef struct SCVString SCVString;
@@ -62,8 +110,21 @@ typedef struct SCVArena SCVArena;
 
 void scvPrintU64(u64 x);
 void scvAssertFail(char *expr, char *file, int line);
+void scvLogFlush(void);
 i64 scvWrite(int fd, void *ptr, u64 size, SCVError *error);
 void* scvArenaAllocAlign(SCVArena *arena, u64 size, SCVError *err, u64 align);
+void* scvArenaAllocAlignNoZero(SCVArena *arena, u64 size, SCVError *err, u64 align);
+void scvProfileBegin(char *name);
+void scvProfileEnd(void);
+
+// zone profiler, see profiler section. Without SCV_PROFILE zones cost nothing
+#ifdef SCV_PROFILE
+#define scvZoneBegin(name) scvProfileBegin(name)
+#define scvZoneEnd() scvProfileEnd()
+#else
+#define scvZoneBegin(name) ((void)0)
+#define scvZoneEnd() ((void)0)
+#endif
 
 struct SCVString {
   u8 *base;
@@ -82,11 +143,60 @@ struct SCVError {
   byte      errbuf[SCV_ERRBUF_SIZE];
 };
 
+// memory telemetry
+//
+// highwater, alloc and per tag numbers are compiled in only with SCV_MEM_STATS
+
+enum SCVMemTag {
+  SCV_MEM_TAG_NONE = 0,
+  SCV_MEM_TAG_VERTEXES,
+  SCV_MEM_TAG_INDICIES,
+  SCV_MEM_TAG_DRAWCALLS,
+  SCV_MEM_TAG_GLYPHS,
+  SCV_MEM_TAG_TEXTURES,
+  SCV_MEM_TAG_FONTS,
+  SCV_MEM_TAG_IMAGES,
+  SCV_MEM_TAG_LOG,
+  SCV_MEM_TAG_PROFILE,
+
+  SCV_MEM_TAG_COUNT
+};
+
+char *scvMemTagNames[SCV_MEM_TAG_COUNT] = {
+  "none",
+  "vertexes",
+  "indicies",
+  "drawcalls",
+  "glyphs",
+  "textures",
+  "fonts",
+  "images",
+  "log",
+  "profile",
+};
+
+typedef struct SCVMemStats SCVMemStats;
+struct SCVMemStats {
+  u64 reserved;
+  u64 committed;
+  u64 used;
+  u64 highWater;
+  u64 allocCount;
+  u64 tagBytes[SCV_MEM_TAG_COUNT];
+  u64 tagCount[SCV_MEM_TAG_COUNT];
+};
+
 struct SCVArena {
   byte *buf;
-  u64  size;
+  u64  size;        // committed bytes
+  u64  reserved;    // reserved address space in bytes
   u64  currOffset;
   u64  prevOffset;
+  u64  dirtyOffset; // everything past it was never handed out and is zero
+  u32  tag;         // enum SCVMemTag of following allocations
+#ifdef SCV_MEM_STATS
+  SCVMemStats stats;
+#endif
 };
 
 // strings
@@ -107,7 +217,7 @@ scvIsStringsEquals(SCVString s1, SCVString s2)
     return false;
   }
 
-  return strncmp((char *)s1.base, (char *)s2.base, s1.len);
+  return memcmp(s1.base, s2.base, s1.len) == 0;
 }
 
 SCVString
@@ -151,7 +261,7 @@ scvString(SCVSlice s)
 
 #define scvSliceAppend(sl, el)                                          \
   do {                                                                  \
-    scvAssert((sl).len < (sl).cap - 1);                                 \
+    scvAssert((sl).len < (sl).cap);                                     \
     memcpy((u8 *)(sl).base + (sl).len * sizeof(el), &(el), sizeof(el)); \
     (sl).len++;                                                         \
   } while (0)
@@ -195,76 +305,496 @@ scvSliceRight(SCVSlice s, u64 rbytes)
   return ret;
 }
 
+char scvDigitPairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+u32
+scvCountDigits(u64 x)
+{
+  u32 n = 1;
+
+  for (;;) {
+    if (x < 10) return n;
+    if (x < 100) return n + 1;
+    if (x < 1000) return n + 2;
+    if (x < 10000) return n + 3;
+    x /= 10000;
+    n += 4;
+  }
+}
+
+// writes decimal digits of x two at a time from the end, buf needs
+// scvCountDigits(x) bytes (20 at most)
+u64
+scvFormatU64(char *buf, u64 x)
+{
+  u32 ndigits = scvCountDigits(x);
+  u32 i = ndigits;
+  u64 pair;
+
+  while (x >= 100) {
+    pair = (x % 100) * 2;
+    x /= 100;
+    buf[--i] = scvDigitPairs[pair + 1];
+    buf[--i] = scvDigitPairs[pair];
+  }
+  if (x >= 10) {
+    buf[--i] = scvDigitPairs[x * 2 + 1];
+    buf[--i] = scvDigitPairs[x * 2];
+  } else {
+    buf[--i] = (char)('0' + x);
+  }
+
+  return ndigits;
+}
+
 u64
 scvSlicePutU64(SCVSlice s, u64 x)
 {
-  int	ndigits = 0, rx = 0, i = 0;
+  char digits[20];
+  u64 n = scvFormatU64(digits, x);
+
+  n = scvMin(n, s.len);
+  memcpy(s.base, digits, n);
+
+  return n;
+}
+
+u64
+scvSlicePutI64(SCVSlice s, i64 x)
+{
   char *buf = s.base;
 
-  if (x == 0) {
-    buf[0] = '0';
-    return 1;
+  if (x < 0 && s.len > 0) {
+    buf[0] = '-';
+    return 1 + scvSlicePutU64(scvSliceLeft(s, 1), (u64)0 - (u64)x);
+  }
+
+  return scvSlicePutU64(s, (u64)x);
+}
+
+u64
+scvSlicePutString(SCVSlice sl, SCVString s)
+{
+  u64 toWrite = scvMin(sl.len, s.len);
+  memcpy(sl.base, s.base, toWrite);
+  return toWrite;
+}
+
+u64
+scvSlicePutCString(SCVSlice sl, char *cstr)
+{
+  return scvSlicePutString(sl, scvUnsafeCString(cstr));
+}
+
+// float formatting
+
+// Grisu2, digits which read back to the same double, no allocation. Almost
+// always the shortest such digits, rarely one digit longer (no Grisu3 fallback)
+
+#define SCV_F64_MAX_CHARS 32
+
+typedef struct SCVDiyFp SCVDiyFp;
+struct SCVDiyFp {
+  u64 f;
+  i32 e;
+};
+
+u64 scvCachedPowersF[] = {
+  0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull,
+  0xcf42894a5dce35eaull, 0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull,
+  0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full, 0xbe5691ef416bd60cull,
+  0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+  0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull,
+  0xc21094364dfb5637ull, 0x9096ea6f3848984full, 0xd77485cb25823ac7ull,
+  0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull, 0xb23867fb2a35b28eull,
+  0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+  0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull,
+  0xb5b5ada8aaff80b8ull, 0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull,
+  0x964e858c91ba2655ull, 0xdff9772470297ebdull, 0xa6dfbd9fb8e5b88full,
+  0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+  0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull,
+  0xaa242499697392d3ull, 0xfd87b5f28300ca0eull, 0xbce5086492111aebull,
+  0x8cbccc096f5088ccull, 0xd1b71758e219652cull, 0x9c40000000000000ull,
+  0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+  0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull,
+  0x9f4f2726179a2245ull, 0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull,
+  0x83c7088e1aab65dbull, 0xc45d1df942711d9aull, 0x924d692ca61be758ull,
+  0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+  0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull,
+  0x952ab45cfa97a0b3ull, 0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull,
+  0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull, 0x88fcf317f22241e2ull,
+  0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+  0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull,
+  0x8bab8eefb6409c1aull, 0xd01fef10a657842cull, 0x9b10a4e5e9913129ull,
+  0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull, 0x80444b5e7aa7cf85ull,
+  0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+  0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull,
+};
+
+i16 scvCachedPowersE[] = {
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+  -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+  -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+  -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+  -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+  109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+  641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+  907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+u64 scvPow10[] = {
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+  10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+  100000000000ull, 1000000000000ull, 10000000000000ull,
+  100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+  100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+};
+
+SCVDiyFp
+scvDiyFp(u64 f, i32 e)
+{
+  SCVDiyFp r;
+
+  r.f = f;
+  r.e = e;
+
+  return r;
+}
+
+SCVDiyFp
+scvDiyFpFromF64(f64 x)
+{
+  u64 bits, significand;
+  i32 biased;
+
+  memcpy(&bits, &x, sizeof(bits));
+  biased = (i32)((bits >> 52) & 0x7ff);
+  significand = bits & ((1ull << 52) - 1);
+
+  if (biased != 0) {
+    return scvDiyFp(significand + (1ull << 52), biased - 1075);
   }
 
-  while (x > 0) {
-    rx = (10 * rx) + (x % 10);
-    x /= 10;
-    ++ndigits;
+  return scvDiyFp(significand, -1074);
+}
+
+// 64x64 multiply keeping rounded upper half, no __int128 in c99
+SCVDiyFp
+scvDiyFpMul(SCVDiyFp x, SCVDiyFp y)
+{
+  u64 m32 = 0xffffffffull;
+  u64 a = x.f >> 32, b = x.f & m32;
+  u64 c = y.f >> 32, d = y.f & m32;
+  u64 ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+  u64 tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+
+  tmp += 1ull << 31;
+
+  return scvDiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+}
+
+SCVDiyFp
+scvDiyFpNormalize(SCVDiyFp x)
+{
+  i32 s = __builtin_clzll(x.f);
+
+  return scvDiyFp(x.f << s, x.e - s);
+}
+
+void
+scvDiyFpBoundaries(SCVDiyFp v, SCVDiyFp *minus, SCVDiyFp *plus)
+{
+  SCVDiyFp pl = scvDiyFp((v.f << 1) + 1, v.e - 1);
+  SCVDiyFp mi;
+
+  while (!(pl.f & (1ull << 53))) {
+    pl.f <<= 1;
+    pl.e--;
   }
+  pl.f <<= 10;
+  pl.e -= 10;
 
-  while (ndigits > 0) {
-    buf[i++] = (rx % 10) + '0';
-    rx /= 10;
-    --ndigits;
+  if (v.f == (1ull << 52)) {
+    mi = scvDiyFp((v.f << 2) - 1, v.e - 2);
+  } else {
+    mi = scvDiyFp((v.f << 1) - 1, v.e - 1);
   }
+  mi.f <<= mi.e - pl.e;
+  mi.e = pl.e;
 
-  return i;
+  *minus = mi;
+  *plus = pl;
 }
 
-u64
-scvSlicePutI64(SCVSlice s, i64 x)
+SCVDiyFp
+scvCachedPower(i32 e, i32 *k)
 {
-  int	ndigits = 0, rx = 0, i = 0;
-  char *buf = s.base;
-  int  sign = x < 0;
+  f64 dk = (f64)(-61 - e) * 0.30102999566398114 + 347;
+  i32 ik = (i32)dk;
+  u32 index;
 
-  if (x == 0) {
-    buf[0] = '0';
-    return 1;
+  if (dk - ik > 0.0) {
+    ik++;
+  }
+  index = (u32)((ik >> 3) + 1);
+  *k = -(-348 + (i32)index * 8);
+
+  return scvDiyFp(scvCachedPowersF[index], scvCachedPowersE[index]);
+}
+
+void
+scvGrisuRound(char *buf, i32 len, u64 delta, u64 rest, u64 tenKappa, u64 wpw)
+{
+  while (rest < wpw && delta - rest >= tenKappa &&
+         (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw)) {
+    buf[len - 1]--;
+    rest += tenKappa;
+  }
+}
+
+void
+scvGrisuDigitGen(SCVDiyFp w, SCVDiyFp mp, u64 delta, char *buf, i32 *len, i32 *k)
+{
+  SCVDiyFp one = scvDiyFp(1ull << -mp.e, mp.e);
+  u64 wpw = mp.f - w.f;
+  u32 p1 = (u32)(mp.f >> -one.e);
+  u64 p2 = mp.f & (one.f - 1);
+  i32 kappa = (i32)scvCountDigits(p1);
+  u64 tmp;
+  u32 d;
+
+  *len = 0;
+
+  while (kappa > 0) {
+    d = p1 / (u32)scvPow10[kappa - 1];
+    p1 %= (u32)scvPow10[kappa - 1];
+    if (d || *len) {
+      buf[(*len)++] = (char)('0' + d);
+    }
+    kappa--;
+    tmp = ((u64)p1 << -one.e) + p2;
+    if (tmp <= delta) {
+      *k += kappa;
+      scvGrisuRound(buf, *len, delta, tmp, scvPow10[kappa] << -one.e, wpw);
+      return;
+    }
+  }
+
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    d = (u32)(p2 >> -one.e);
+    if (d || *len) {
+      buf[(*len)++] = (char)('0' + d);
+    }
+    p2 &= one.f - 1;
+    kappa--;
+    if (p2 < delta) {
+      *k += kappa;
+      scvGrisuRound(buf, *len, delta, p2, one.f, -kappa < 20 ? wpw * scvPow10[-kappa] : 0);
+      return;
+    }
+  }
+}
+
+// x must be finite and positive, writes digits only, value is digits * 10^k
+i32
+scvGrisu2(f64 x, char *buf, i32 *k)
+{
+  SCVDiyFp v = scvDiyFpFromF64(x);
+  SCVDiyFp mi, pl, c, w, wp, wm;
+  i32 len;
+
+  scvDiyFpBoundaries(v, &mi, &pl);
+  c = scvCachedPower(pl.e, k);
+  w = scvDiyFpMul(scvDiyFpNormalize(v), c);
+  wp = scvDiyFpMul(pl, c);
+  wm = scvDiyFpMul(mi, c);
+  wm.f++;
+  wp.f--;
+  scvGrisuDigitGen(w, wp, wp.f - wm.f, buf, &len, k);
+
+  return len;
+}
+
+i32
+scvFormatExponent(char *buf, i32 e)
+{
+  i32 n = 0;
+
+  buf[n++] = 'e';
+  if (e < 0) {
+    buf[n++] = '-';
+    e = -e;
+  }
+  if (e >= 100) {
+    buf[n++] = (char)('0' + e / 100);
+    e %= 100;
+    buf[n++] = scvDigitPairs[e * 2];
+    buf[n++] = scvDigitPairs[e * 2 + 1];
+  } else if (e >= 10) {
+    buf[n++] = scvDigitPairs[e * 2];
+    buf[n++] = scvDigitPairs[e * 2 + 1];
+  } else {
+    buf[n++] = (char)('0' + e);
+  }
+
+  return n;
+}
+
+// round trip and usually shortest representation, plain notation for
+// 1e-6 <= |x| < 1e21 (1.5, 100, 0.001), exponent otherwise (1e21, 2.5e-7),
+// nan/inf/-inf.
+// buf needs SCV_F64_MAX_CHARS bytes
+u64
+scvFormatF64(char *buf, f64 x)
+{
+  char *p = buf;
+  u64 bits;
+  i32 len, k, kk, i;
+
+  memcpy(&bits, &x, sizeof(bits));
+  if (((bits >> 52) & 0x7ff) == 0x7ff) {
+    if (bits & ((1ull << 52) - 1)) {
+      memcpy(buf, "nan", 3);
+      return 3;
+    }
+    if (bits >> 63) {
+      memcpy(buf, "-inf", 4);
+      return 4;
+    }
+    memcpy(buf, "inf", 3);
+    return 3;
   }
 
-  if (sign) {
+  if (bits >> 63) {
+    *p++ = '-';
     x = -x;
-    buf[i++] = '-';
   }
+  if (x == 0.0) {
+    *p++ = '0';
+    return (u64)(p - buf);
+  }
+
+  len = scvGrisu2(x, p, &k);
+  kk = len + k; // 10^(kk-1) <= x < 10^kk
+
+  if (k >= 0 && kk <= 21) {
+    // 1234e3 -> 1234000
+    for (i = len; i < kk; ++i) {
+      p[i] = '0';
+    }
+    p += kk;
+  } else if (kk > 0 && kk <= 21) {
+    // 1234e-2 -> 12.34
+    memmove(p + kk + 1, p + kk, (u64)(len - kk));
+    p[kk] = '.';
+    p += len + 1;
+  } else if (kk > -6 && kk <= 0) {
+    // 1234e-6 -> 0.001234
+    memmove(p + 2 - kk, p, (u64)len);
+    p[0] = '0';
+    p[1] = '.';
+    for (i = 2; i < 2 - kk; ++i) {
+      p[i] = '0';
+    }
+    p += len + 2 - kk;
+  } else if (len == 1) {
+    // 1e30
+    p += 1;
+    p += scvFormatExponent(p, kk - 1);
+  } else {
+    // 1234e30 -> 1.234e33
+    memmove(p + 2, p + 1, (u64)(len - 1));
+    p[1] = '.';
+    p += len + 1;
+    p += scvFormatExponent(p, kk - 1);
+  }
+
+  return (u64)(p - buf);
+}
+
+// fixed number of decimals (at most 9), rounded half away from zero after
+// scaling by 10^decimals, so -2.005 gives -2.01 where printf gives -2.00.
+// Values too big for fixed point integer fall back to scvFormatF64.
+u64
+scvFormatF64Fixed(char *buf, f64 x, u32 decimals)
+{
+  char *p = buf;
+  u64 scale, v, ipart, fpart;
+  u32 n;
 
-  while (x > 0) {
-    rx = (10 * rx) + (x % 10);
-    x /= 10;
-    ++ndigits;
+  scvAssert(decimals <= 9);
+  scale = scvPow10[decimals];
+
+  if (x != x || x >= 9.2e18 / (f64)scale || x <= -9.2e18 / (f64)scale) {
+    return scvFormatF64(buf, x);
   }
 
-  while (ndigits > 0) {
-    buf[i++] = (rx % 10) + '0';
-    rx /= 10;
-    --ndigits;
+  if (x < 0) {
+    x = -x;
+    *p++ = '-';
+  }
+  v = (u64)(x * (f64)scale + 0.5);
+  if (v == 0 && p != buf) {
+    p--; // don't print -0.00
+  }
+  ipart = v / scale;
+  fpart = v % scale;
+
+  p += scvFormatU64(p, ipart);
+  if (decimals) {
+    *p++ = '.';
+    n = scvCountDigits(fpart);
+    memset(p, '0', decimals - n);
+    scvFormatU64(p + decimals - n, fpart);
+    p += decimals;
   }
 
-  return i;
+  return (u64)(p - buf);
 }
 
+// lowercase hex, zero padded to at least minDigits, buf needs 16 bytes
 u64
-scvSlicePutString(SCVSlice sl, SCVString s)
+scvFormatHex(char *buf, u64 x, u32 minDigits)
 {
-  u64 toWrite = scvMin(sl.len, s.len);
-  memcpy(sl.base, s.base, toWrite);
-  return toWrite;
+  char *hex = "0123456789abcdef";
+  u32 n = 1, i;
+
+  if (x) {
+    n = (u32)(64 - __builtin_clzll(x) + 3) / 4;
+  }
+  n = scvMax(n, scvMin(minDigits, 16));
+
+  for (i = n; i > 0; --i) {
+    buf[i - 1] = hex[x & 0xf];
+    x >>= 4;
+  }
+
+  return n;
 }
 
 u64
-scvSlicePutCString(SCVSlice sl, char *cstr)
+scvSlicePutF64(SCVSlice s, f64 x)
 {
-  return scvSlicePutString(sl, scvUnsafeCString(cstr));
+  char buf[SCV_F64_MAX_CHARS];
+  u64 n = scvFormatF64(buf, x);
+
+  n = scvMin(n, s.len);
+  memcpy(s.base, buf, n);
+
+  return n;
 }
 
 SCVSlice
@@ -295,6 +825,13 @@ struct SCVSyscallResult {
 SCVSyscallResult scvSyscall(uptr trap, uptr a1, uptr a2, uptr a3);
 SCVSyscallResult scvSyscall6(uptr trap, uptr a1, uptr a2, uptr a3, uptr a4, uptr a5, uptr a6);
 
+// darwin has only fstat64 for 64 bit struct stat
+#ifdef __linux__
+#define SCV_SYS_FSTAT SYS_fstat
+#else
+#define SCV_SYS_FSTAT SYS_fstat64
+#endif
+
 void 
 scvErrorSet(SCVError* err, char* msg, uptr tag) 
 {
@@ -364,7 +901,7 @@ scvOpenat(i32 dirfd, SCVString pathname, i32 flags, mode_t mode, SCVError *err)
 void
 scvFStat(i32 fd, struct stat *s, SCVError *err)
 {
-  SCVSyscallResult r = scvSyscall(SYS_fstat64, (uptr)fd, (uptr)s, 0);
+  SCVSyscallResult r = scvSyscall(SCV_SYS_FSTAT, (uptr)fd, (uptr)s, 0);
   scvErrorSet(err, "fstat failed with code", r.err);
 }
 
@@ -373,6 +910,9 @@ scvMmap(void *addr, u64 len, i32 prot, i32 flags, i32 fd, i64 offset, SCVError *
 {
   SCVSyscallResult r = scvSyscall6(SYS_mmap, (uptr)addr, (uptr)len, (uptr)prot, (uptr)flags, (uptr)fd, (uptr)offset);
   scvErrorSet(error, "mmap failed with code", r.err);
+  if (r.err) {
+    return nil;
+  }
 
   return (void *)r.r1;
 }
@@ -384,6 +924,13 @@ scvMunmap(void *addr, u64 len, SCVError *error)
   scvErrorSet(error, "mmap failed with code", r.err);
 }
 
+void
+scvMprotect(void *addr, u64 len, i32 prot, SCVError *error)
+{
+  SCVSyscallResult r = scvSyscall(SYS_mprotect, (uptr)addr, (uptr)len, (uptr)prot);
+  scvErrorSet(error, "mprotect failed with code", r.err);
+}
+
 void
 scvSliceMunmap(SCVSlice s)
 {
@@ -462,6 +1009,7 @@ scvPrintError(SCVError *err)
 void
 scvFatalError(char *msg, SCVError *err)
 {
+  scvLogFlush();
   scvPrintCString(msg);
   scvPrintError(err);
   scvExit(1);
@@ -484,6 +1032,7 @@ scvAssertFail(char *expr, char *file, int line)
   n += scvSlicePutCString(scvSliceLeft(s, n), expr);
   n += scvSlicePutCString(scvSliceLeft(s, n), "' failed.");
 
+  scvLogFlush();
   scvPrintString(scvString(scvSliceRight(s, n)));
   scvBreakpoint;
 }
@@ -570,9 +1119,9 @@ scvTimeToTm(i64 t)
 u64 scvCntFrq(void);
 u64 scvCntVct(void);
 
-#ifdef __APPLE__
- #ifdef __aarch64__
+#if defined(__aarch64__)
 
+// NOTE: cntvct_el0 is readable from EL0 both on darwin and linux
 u64 
 scvCntVct(void)
 {
@@ -589,7 +1138,53 @@ scvCntFrq(void)
     __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
     return freq;
 }
- #endif
+
+#elif defined(__x86_64__) && defined(__linux__)
+
+#define SCV_TSC_CALIBRATION_NS 10000000
+
+u64 scvTscFreq = 0;
+
+u64
+scvCntVct(void)
+{
+  u32 lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+
+  return ((u64)hi << 32) | (u64)lo;
+}
+
+u64
+scvMonotonicNs(void)
+{
+  struct timespec ts = {0};
+  scvSyscall(SYS_clock_gettime, CLOCK_MONOTONIC, (uptr)&ts, 0);
+
+  return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+// expects invariant tsc, frequency is measured once and cached
+u64
+scvCntFrq(void)
+{
+  u64 ns0, ns1, tsc0, tsc1;
+
+  if (scvTscFreq) {
+    return scvTscFreq;
+  }
+
+  ns0  = scvMonotonicNs();
+  tsc0 = scvCntVct();
+  do {
+    ns1 = scvMonotonicNs();
+  } while (ns1 - ns0 < SCV_TSC_CALIBRATION_NS);
+  tsc1 = scvCntVct();
+
+  scvTscFreq = (u64)((f64)(tsc1 - tsc0) * 1000000000.0 / (f64)(ns1 - ns0));
+
+  return scvTscFreq;
+}
+
 #endif
 
 enum SCVTimerType {
@@ -635,6 +1230,9 @@ scvTimerToc(SCVTimer *timer, enum SCVTimerType t)
 
 // Arena
 
+// reserves address space once and commits pages on demand, buf never moves.
+// Pages past dirtyOffset are fresh from the kernel and already zero.
+
 uptr 
 scvAlignForward(uptr ptr, u64 align)
 {
@@ -657,218 +1255,3941 @@ scvAlignForward(uptr ptr, u64 align)
 u64
 scvSizeRoundUp(u64 size)
 {
-  return size + (PAGE_SIZE - (size & (PAGE_SIZE - 1)));
+  return (u64)scvAlignForward((uptr)size, SCV_PAGE_SIZE);
 }
 
-void*
-scvMmapRealloc(void *prev, u64 prevSize, u64 size, SCVError *err)
+void
+scvArenaInitReserve(SCVArena *arena, u64 reserve, SCVError *err)
 {
-  void *addr;
-  i32  flags;
+  void *buf;
 
-  if (size == 0) {
-    return nil;
-  }
+  scvAssert(arena);
+  arena->buf = nil;
+  arena->size = 0;
+  arena->reserved = 0;
+  arena->currOffset = 0;
+  arena->prevOffset = 0;
+  arena->dirtyOffset = 0;
+  arena->tag = SCV_MEM_TAG_NONE;
+#ifdef SCV_MEM_STATS
+  scvClear(&arena->stats, sizeof(arena->stats));
+#endif
 
-  if (prev == nil) {
-    addr = nil;
-    flags = 0;
-  } else {
-    addr = (u8 *)prev + prevSize;
-    flags = MAP_FIXED;
+  reserve = scvSizeRoundUp(reserve);
+  buf = scvMmap(nil, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0, err);
+  if (!buf) {
+    return;
   }
 
-  return scvMmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | flags, -1, 0, err);
+  arena->buf = buf;
+  arena->reserved = reserve;
 }
 
 void
 scvArenaInit(SCVArena *arena, SCVError *err)
 {
-  (void)err;
-  scvAssert(arena);
+  scvArenaInitReserve(arena, SCV_ARENA_DEFAULT_RESERVE, err);
+}
+
+void
+scvArenaRelease(SCVArena *arena)
+{
+  if (arena->buf) {
+    scvMunmap(arena->buf, arena->reserved, nil);
+  }
   arena->buf = nil;
   arena->size = 0;
+  arena->reserved = 0;
   arena->currOffset = 0;
   arena->prevOffset = 0;
+  arena->dirtyOffset = 0;
+}
+
+bool
+scvArenaCommit(SCVArena *arena, u64 size, SCVError *err)
+{
+  u64 commit;
+  SCVError error = {0};
+
+  if (size <= arena->size) {
+    return true;
+  }
+  if (size > arena->reserved) {
+    scvErrorSet(err, "arena reserve exhausted", (uptr)SCV_ARENA_OUT_OF_RESERVE);
+    return false;
+  }
+
+  commit = scvSizeRoundUp(scvMax(size - arena->size, SCV_ARENA_COMMIT_SIZE));
+  commit = scvMin(commit, arena->reserved - arena->size);
+
+  scvMprotect(arena->buf + arena->size, commit, PROT_READ | PROT_WRITE, &error);
+  if (error.tag) {
+    if (err) {
+      *err = error;
+    }
+    return false;
+  }
+  arena->size += commit;
+
+  return true;
 }
 
 void*
-scvArenaAllocAlign(SCVArena *arena, u64 size, SCVError *err, u64 align)
+scvArenaAllocAlignNoZero(SCVArena *arena, u64 size, SCVError *err, u64 align)
 {
   uptr currPtr = (uptr)arena->buf + (uptr)arena->currOffset;
   uptr offset  = scvAlignForward(currPtr, align);
   offset -= (uptr)arena->buf;
 
-  if (offset + size > arena->size) {
-    void *next = scvMmapRealloc(arena->buf, arena->size, scvSizeRoundUp(size), err);
-    if (!next) {
-      return nil;
-    }
-    if (arena->buf == nil) {
-      arena->buf = next;
-    }
-    arena->size += scvSizeRoundUp(size);
+  if (offset + size > arena->size && !scvArenaCommit(arena, offset + size, err)) {
+    return nil;
   }
 
-  void *ptr = &arena->buf[offset];
   arena->prevOffset = offset;
   arena->currOffset = offset + size;
-  memset(ptr, 0, size);
 
-  return ptr;
+#ifdef SCV_MEM_STATS
+  arena->stats.allocCount++;
+  arena->stats.tagCount[arena->tag]++;
+  arena->stats.tagBytes[arena->tag] += size;
+  arena->stats.highWater = scvMax(arena->stats.highWater, arena->currOffset);
+#endif
+
+  return &arena->buf[offset];
 }
 
-enum SCVLogLevel {
-  SCV_LOG_PANIC = 0,
-  SCV_LOG_ERROR = 1,
-  SCV_LOG_WARN  = 2,
-  SCV_LOG_INFO  = 3,
-};
+// returns previous tag so caller can restore it
+u32
+scvArenaSetTag(SCVArena *arena, u32 tag)
+{
+  u32 prev = arena->tag;
 
-void 
-scvLog(
-    char *tag,
-    enum SCVLogLevel level,
-    u32 logitem,
-    char* msg,
-    u32 line,
-    char* filename
-);
+  scvAssert(tag < SCV_MEM_TAG_COUNT);
+  arena->tag = tag;
 
+  return prev;
+}
 
-#define scvWarn(tag, msg) scvLog(tag, SCV_LOG_WARN, 0, msg, __LINE__, __FILE__)
+void*
+scvArenaAllocAlign(SCVArena *arena, u64 size, SCVError *err, u64 align)
+{
+  u8 *ptr = scvArenaAllocAlignNoZero(arena, size, err, align);
+  u64 offset;
+
+  if (!ptr) {
+    return nil;
+  }
+
+  offset = arena->prevOffset;
+  if (offset < arena->dirtyOffset) {
+    memset(ptr, 0, scvMin(size, arena->dirtyOffset - offset));
+  }
+
+  return ptr;
+}
+
+// grows last allocation in place, fails if ptr is not the last allocation
+// or reserve is exhausted. New tail is not zeroed.
+bool
+scvArenaExtend(SCVArena *arena, void *ptr, u64 newSize, SCVError *err)
+{
+  u64 offset = arena->prevOffset;
+
+  if ((u8 *)ptr != arena->buf + offset) {
+    return false;
+  }
+  if (offset + newSize > arena->size && !scvArenaCommit(arena, offset + newSize, err)) {
+    return false;
+  }
+
+#ifdef SCV_MEM_STATS
+  if (offset + newSize > arena->currOffset) {
+    arena->stats.tagBytes[arena->tag] += offset + newSize - arena->currOffset;
+  }
+#endif
+  arena->currOffset = scvMax(arena->currOffset, offset + newSize);
+#ifdef SCV_MEM_STATS
+  arena->stats.highWater = scvMax(arena->stats.highWater, arena->currOffset);
+#endif
+
+  return true;
+}
+
+void
+scvArenaReset(SCVArena *arena)
+{
+  arena->dirtyOffset = scvMax(arena->dirtyOffset, arena->currOffset);
+  arena->currOffset = 0;
+  arena->prevOffset = 0;
+#ifdef SCV_MEM_STATS
+  arena->stats.allocCount = 0;
+  scvClear(arena->stats.tagBytes, sizeof(arena->stats.tagBytes));
+  scvClear(arena->stats.tagCount, sizeof(arena->stats.tagCount));
+#endif
+}
+
+typedef struct SCVArenaTemp SCVArenaTemp;
+struct SCVArenaTemp {
+  SCVArena *arena;
+  u64      currOffset;
+  u64      prevOffset;
+#ifdef SCV_MEM_STATS
+  // counters are rolled back with offsets, like after reset
+  u64      allocCount;
+  u64      tagBytes[SCV_MEM_TAG_COUNT];
+  u64      tagCount[SCV_MEM_TAG_COUNT];
+#endif
+};
+
+SCVArenaTemp
+scvArenaTempBegin(SCVArena *arena)
+{
+  SCVArenaTemp temp;
+
+  temp.arena = arena;
+  temp.currOffset = arena->currOffset;
+  temp.prevOffset = arena->prevOffset;
+#ifdef SCV_MEM_STATS
+  temp.allocCount = arena->stats.allocCount;
+  memcpy(temp.tagBytes, arena->stats.tagBytes, sizeof(temp.tagBytes));
+  memcpy(temp.tagCount, arena->stats.tagCount, sizeof(temp.tagCount));
+#endif
+
+  return temp;
+}
+
+void
+scvArenaTempEnd(SCVArenaTemp temp)
+{
+  SCVArena *arena = temp.arena;
+
+  scvAssert(temp.currOffset <= arena->currOffset);
+  arena->dirtyOffset = scvMax(arena->dirtyOffset, arena->currOffset);
+  arena->currOffset = temp.currOffset;
+  arena->prevOffset = temp.prevOffset;
+#ifdef SCV_MEM_STATS
+  arena->stats.allocCount = temp.allocCount;
+  memcpy(arena->stats.tagBytes, temp.tagBytes, sizeof(temp.tagBytes));
+  memcpy(arena->stats.tagCount, temp.tagCount, sizeof(temp.tagCount));
+#endif
+}
+
+// scratch arenas
+
+// per thread scratch arenas, released when the thread exits. Function which
+// gets output arena from caller passes it as conflict, so scratch never
+// aliases caller's allocations.
+
+#ifndef SCV_SCRATCH_COUNT
+#define SCV_SCRATCH_COUNT 2
+#endif
+
+#ifndef SCV_SCRATCH_RESERVE
+#define SCV_SCRATCH_RESERVE (8ull << 30)
+#endif
+
+scvThreadLocal SCVArena scvScratchArenas[SCV_SCRATCH_COUNT];
+pthread_key_t  scvScratchKey;
+pthread_once_t scvScratchKeyOnce = PTHREAD_ONCE_INIT;
+
+// runs on thread exit, value is exiting thread's scvScratchArenas
+void
+scvScratchRelease(void *arenas)
+{
+  u64 i;
+
+  for (i = 0; i < SCV_SCRATCH_COUNT; ++i) {
+    scvArenaRelease((SCVArena *)arenas + i);
+  }
+}
+
+void
+scvScratchKeyInit(void)
+{
+  scvAssert(pthread_key_create(&scvScratchKey, scvScratchRelease) == 0);
+}
+
+SCVArena*
+scvScratchGet(SCVArena **conflicts, u64 count)
+{
+  u64 i, j;
+  SCVArena *arena;
+  SCVError error = {0};
+
+  for (i = 0; i < SCV_SCRATCH_COUNT; ++i) {
+    arena = &scvScratchArenas[i];
+    for (j = 0; j < count; ++j) {
+      if (conflicts[j] == arena) {
+        break;
+      }
+    }
+    if (j < count) {
+      continue;
+    }
+    if (arena->buf == nil) {
+      scvArenaInitReserve(arena, SCV_SCRATCH_RESERVE, &error);
+      if (error.tag) {
+        scvFatalError("can't reserve scratch arena", &error);
+      }
+      // reserve goes back when thread exits
+      pthread_once(&scvScratchKeyOnce, scvScratchKeyInit);
+      pthread_setspecific(scvScratchKey, scvScratchArenas);
+    }
+    return arena;
+  }
+
+  scvAssert(0 && "all scratch arenas are in conflict");
+  return nil;
+}
+
+SCVArenaTemp
+scvScratchBegin(SCVArena **conflicts, u64 count)
+{
+  return scvArenaTempBegin(scvScratchGet(conflicts, count));
+}
+
+void
+scvScratchEnd(SCVArenaTemp temp)
+{
+  scvArenaTempEnd(temp);
+}
+
+// call on frame/message boundary, when nothing from scratch is alive
+void
+scvScratchReset(void)
+{
+  u64 i;
+
+  for (i = 0; i < SCV_SCRATCH_COUNT; ++i) {
+    if (scvScratchArenas[i].buf) {
+      scvArenaReset(&scvScratchArenas[i]);
+    }
+  }
+}
+
+// dynamic arrays
+
+// arena backed growable array, element pointers are valid until next push
+
+typedef struct SCVArray SCVArray;
+struct SCVArray {
+  void     *base;
+  u64      len;  // in elements
+  u64      cap;  // in elements
+  u64      size; // of element
+  SCVArena *arena;
+  u32      tag;  // memory tag of arena at creation, used for every grow
+};
+
+SCVArray
+scvArray(SCVArena *arena, u64 size, u64 cap)
+{
+  SCVArray a;
+
+  a.arena = arena;
+  a.tag = arena->tag;
+  a.size = size;
+  a.len = 0;
+  a.cap = scvMax(cap, 1);
+  a.base = scvArenaAllocNoZero(arena, a.size * a.cap);
+  scvAssert(a.base);
+
+  return a;
+}
+
+#define scvMakeArray(arena, type, cap) scvArray((arena), sizeof(type), (cap))
+
+// makes room for at least need elements in total
+bool
+scvArrayGrow(SCVArray *a, u64 need, SCVError *err)
+{
+  u64 cap = scvMax(a->cap * 2, need);
+  u32 prevTag;
+  void *base;
+
+  if (need <= a->cap) {
+    return true;
+  }
+
+  prevTag = scvArenaSetTag(a->arena, a->tag);
+  if (scvArenaExtend(a->arena, a->base, cap * a->size, err)) {
+    a->cap = cap;
+    scvArenaSetTag(a->arena, prevTag);
+    return true;
+  }
+
+  base = nil;
+  if (!err || !err->tag) {
+    base = scvArenaAllocAlignNoZero(a->arena, cap * a->size, err, SCV_DEFAULT_ALIGNMENT);
+  }
+  scvArenaSetTag(a->arena, prevTag);
+  if (!base) {
+    return false;
+  }
+  memcpy(base, a->base, a->len * a->size);
+  a->base = base;
+  a->cap = cap;
+
+  return true;
+}
+
+// room for n more elements
+bool
+scvArrayReserve(SCVArray *a, u64 n, SCVError *err)
+{
+  return scvArrayGrow(a, a->len + n, err);
+}
+
+// n new elements at the end, contents are not initialized
+void*
+scvArrayPushN(SCVArray *a, u64 n)
+{
+  u64 len = a->len;
+  SCVError error = {0};
+
+  if (len + n > a->cap && !scvArrayGrow(a, len + n, &error)) {
+    scvFatalError("array can't grow", &error);
+  }
+  a->len = len + n;
+
+  return (u8 *)a->base + len * a->size;
+}
+
+void*
+scvArrayAppend(SCVArray *a, void *items, u64 n)
+{
+  void *dst = scvArrayPushN(a, n);
+
+  memcpy(dst, items, n * a->size);
+
+  return dst;
+}
+
+#define scvArrayPush(a, type, el)                     \
+  do {                                                \
+    scvAssert(sizeof(type) == (a)->size);             \
+    *(type *)scvArrayPushN((a), 1) = (el);            \
+  } while (0)
+
+#define scvArrayGet(a, type, i) (&((type *)(a)->base)[(i)])
+#define scvArrayLast(a, type) scvArrayGet((a), type, (a)->len - 1)
+#define scvArrayClear(a) ((a)->len = 0)
+
+// view of current contents, valid until next push
+SCVSlice
+scvArraySlice(SCVArray *a)
+{
+  SCVSlice s;
+
+  s.base = a->base;
+  s.len = a->len;
+  s.cap = a->cap;
+
+  return s;
+}
+
+// sorting
+
+// stable LSD radix sort, tmp needs len elements, result ends up in keys
+void
+scvRadixSortU64(u64 *keys, u64 *tmp, u64 len)
+{
+  u64 counts[256];
+  u64 *src = keys, *dst = tmp, *t;
+  u64 i, sum, c;
+  u32 shift;
+
+  for (shift = 0; shift < 64; shift += 8) {
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < len; ++i) {
+      counts[(src[i] >> shift) & 0xff]++;
+    }
+    if (len == 0 || counts[(src[0] >> shift) & 0xff] == len) {
+      continue;
+    }
+    for (i = 0, sum = 0; i < 256; ++i) {
+      c = counts[i];
+      counts[i] = sum;
+      sum += c;
+    }
+    for (i = 0; i < len; ++i) {
+      dst[counts[(src[i] >> shift) & 0xff]++] = src[i];
+    }
+    t = src;
+    src = dst;
+    dst = t;
+  }
+
+  if (src != keys) {
+    memcpy(keys, src, len * sizeof(u64));
+  }
+}
+
+// writer
+
+// buffered output into caller's buffer, first error sticks in w->err
+
+typedef struct SCVWriter SCVWriter;
+struct SCVWriter {
+  u8       *buf;
+  u64      len;
+  u64      cap;
+  int      fd;      // -1 for arena writer
+  SCVArena *arena;
+  u64      flushed; // bytes already written to fd
+  SCVError err;
+};
+
+void
+scvWriterFd(SCVWriter *w, int fd, SCVSlice buffer)
+{
+  scvClear(w, sizeof(*w));
+  w->buf = buffer.base;
+  w->cap = buffer.len;
+  w->fd = fd;
+}
+
+void
+scvWriterArena(SCVWriter *w, SCVArena *arena, u64 initialCap)
+{
+  scvClear(w, sizeof(*w));
+  w->fd = -1;
+  w->arena = arena;
+  w->cap = scvMax(initialCap, 64);
+  w->buf = scvArenaAllocAlignNoZero(arena, w->cap, &w->err, 1);
+  if (!w->buf) {
+    w->cap = 0;
+  }
+}
+
+void
+scvWriterFlush(SCVWriter *w)
+{
+  u64 off = 0;
+  i64 n;
+
+  if (w->fd < 0 || w->err.tag) {
+    return;
+  }
+  while (off < w->len) {
+    n = scvWrite(w->fd, w->buf + off, w->len - off, &w->err);
+    if (w->err.tag || n <= 0) {
+      break;
+    }
+    off += (u64)n;
+  }
+  w->flushed += off;
+  w->len = 0;
+}
+
+bool
+scvWriterGrow(SCVWriter *w, u64 need)
+{
+  u64 cap = scvMax(w->cap * 2, need);
+  u8 *buf;
+
+  if (scvArenaExtend(w->arena, w->buf, cap, &w->err)) {
+    w->cap = cap;
+    return true;
+  }
+  if (w->err.tag) {
+    return false;
+  }
+
+  buf = scvArenaAllocAlignNoZero(w->arena, cap, &w->err, 1);
+  if (!buf) {
+    return false;
+  }
+  memcpy(buf, w->buf, w->len);
+  w->buf = buf;
+  w->cap = cap;
+
+  return true;
+}
+
+// returns room for n bytes at the end of buffer or nil,
+// caller advances w->len by what it actually wrote
+u8*
+scvWriterReserve(SCVWriter *w, u64 n)
+{
+  if (w->err.tag) {
+    return nil;
+  }
+  if (w->len + n > w->cap) {
+    if (w->fd >= 0) {
+      scvWriterFlush(w);
+      if (n > w->cap) {
+        return nil;
+      }
+    } else if (!scvWriterGrow(w, w->len + n)) {
+      return nil;
+    }
+  }
+
+  return w->buf + w->len;
+}
+
+void
+scvWriterPutBytes(SCVWriter *w, void *ptr, u64 size)
+{
+  u8 *p = scvWriterReserve(w, size);
+
+  if (p) {
+    memcpy(p, ptr, size);
+    w->len += size;
+  } else if (w->fd >= 0 && !w->err.tag) {
+    // bigger than whole buffer, buffer is already flushed
+    w->len = 0;
+    while (size > 0) {
+      i64 n = scvWrite(w->fd, ptr, size, &w->err);
+      if (w->err.tag || n <= 0) {
+        break;
+      }
+      ptr = (u8 *)ptr + n;
+      size -= (u64)n;
+      w->flushed += (u64)n;
+    }
+  }
+}
+
+void
+scvWriterPutString(SCVWriter *w, SCVString s)
+{
+  scvWriterPutBytes(w, s.base, s.len);
+}
+
+void
+scvWriterPutCString(SCVWriter *w, char *cstr)
+{
+  scvWriterPutBytes(w, cstr, strlen(cstr));
+}
+
+void
+scvWriterPutByte(SCVWriter *w, u8 c)
+{
+  u8 *p = scvWriterReserve(w, 1);
+
+  if (p) {
+    *p = c;
+    w->len++;
+  }
+}
+
+void
+scvWriterPutU64(SCVWriter *w, u64 x)
+{
+  u8 *p = scvWriterReserve(w, 20);
+
+  if (p) {
+    w->len += scvFormatU64((char *)p, x);
+  }
+}
+
+void
+scvWriterPutI64(SCVWriter *w, i64 x)
+{
+  u8 *p = scvWriterReserve(w, 21);
+
+  if (!p) {
+    return;
+  }
+  if (x < 0) {
+    *p++ = '-';
+    w->len++;
+    w->len += scvFormatU64((char *)p, (u64)0 - (u64)x);
+  } else {
+    w->len += scvFormatU64((char *)p, (u64)x);
+  }
+}
+
+// right aligned in width columns, padded with pad ('0' or ' ')
+void
+scvWriterPutU64Pad(SCVWriter *w, u64 x, u32 width, u8 pad)
+{
+  u32 n = scvCountDigits(x);
+  u8 *p = scvWriterReserve(w, scvMax(n, width));
+
+  if (!p) {
+    return;
+  }
+  if (width > n) {
+    memset(p, pad, width - n);
+    p += width - n;
+    w->len += width - n;
+  }
+  w->len += scvFormatU64((char *)p, x);
+}
+
+void
+scvWriterPutHex(SCVWriter *w, u64 x, u32 minDigits)
+{
+  u8 *p = scvWriterReserve(w, 16);
+
+  if (p) {
+    w->len += scvFormatHex((char *)p, x, minDigits);
+  }
+}
+
+void
+scvWriterPutF64(SCVWriter *w, f64 x)
+{
+  u8 *p = scvWriterReserve(w, SCV_F64_MAX_CHARS);
+
+  if (p) {
+    w->len += scvFormatF64((char *)p, x);
+  }
+}
+
+void
+scvWriterPutF64Fixed(SCVWriter *w, f64 x, u32 decimals)
+{
+  u8 *p = scvWriterReserve(w, SCV_F64_MAX_CHARS);
+
+  if (p) {
+    w->len += scvFormatF64Fixed((char *)p, x, decimals);
+  }
+}
+
+// contents of arena writer, stays valid while arena isn't reset
+SCVString
+scvWriterString(SCVWriter *w)
+{
+  SCVString s;
+
+  s.base = w->buf;
+  s.len = w->len;
+
+  return s;
+}
+
+// threads
+
+typedef pthread_t SCVThread;
+typedef void* (*SCVThreadProc)(void *arg);
+
+bool
+scvThreadCreate(SCVThread *thread, SCVThreadProc proc, void *arg)
+{
+  return pthread_create(thread, nil, proc, arg) == 0;
+}
+
+void
+scvThreadJoin(SCVThread thread)
+{
+  pthread_join(thread, nil);
+}
+
+void
+scvThreadYield(void)
+{
+  sched_yield();
+}
+
+// cpus this process may run on
+u32
+scvCpuCount(void)
+{
+#if defined(__linux__)
+  u64 mask[16] = {0};
+  u32 i, count = 0;
+  SCVSyscallResult r = scvSyscall(SYS_sched_getaffinity, 0, sizeof(mask), (uptr)mask);
+
+  if (r.err) {
+    return 1;
+  }
+  for (i = 0; i < sizeof(mask) / sizeof(mask[0]); ++i) {
+    count += (u32)__builtin_popcountll(mask[i]);
+  }
+  return scvMax(count, 1);
+#else
+  u32 count = 0;
+  size_t len = sizeof(count);
+
+  if (sysctlbyname("hw.activecpu", &count, &len, nil, 0) != 0) {
+    return 1;
+  }
+  return scvMax(count, 1);
+#endif
+}
+
+// logging
+
+enum SCVLogLevel {
+  SCV_LOG_PANIC = 0,
+  SCV_LOG_ERROR = 1,
+  SCV_LOG_WARN  = 2,
+  SCV_LOG_INFO  = 3,
+};
+
+void 
+scvLog(
+    char *tag,
+    enum SCVLogLevel level,
+    u32 logitem,
+    char* msg,
+    u32 line,
+    char* filename
+);
+
+void
+scvLogArgs(
+    char *tag,
+    enum SCVLogLevel level,
+    u32 logitem,
+    char* msg,
+    u32 line,
+    char* filename,
+    u32 argc,
+    u64 *args
+);
+
+#define scvWarn(tag, msg) scvLog(tag, SCV_LOG_WARN, 0, msg, __LINE__, __FILE__)
+
+#define scvInfo(tag, msg) scvLog(tag, SCV_LOG_INFO, 0, msg, __LINE__, __FILE__)
+
+#define scvInfoID(tag, msg, id) scvLog(tag, SCV_LOG_INFO, id, msg, __LINE__, __FILE__)
+
+// up to SCV_LOG_MAX_ARGS integer args, printed after message
+#define scvInfoArgs(tag, msg, ...)                                         \
+  scvLogArgs(tag, SCV_LOG_INFO, 0, msg, __LINE__, __FILE__,                \
+      sizeof((u64[]){ __VA_ARGS__ }) / sizeof(u64), (u64[]){ __VA_ARGS__ })
+
+#define scvWarnArgs(tag, msg, ...)                                         \
+  scvLogArgs(tag, SCV_LOG_WARN, 0, msg, __LINE__, __FILE__,                \
+      sizeof((u64[]){ __VA_ARGS__ }) / sizeof(u64), (u64[]){ __VA_ARGS__ })
+
+// after scvLogStart records go to ring of calling thread and background
+// thread writes them, so tag, msg and filename must outlive logger
+
+#ifndef SCV_LOG_RING_SIZE
+#define SCV_LOG_RING_SIZE 1024
+#endif
+
+#ifndef SCV_LOG_BATCH_SIZE
+#define SCV_LOG_BATCH_SIZE (64 * 1024)
+#endif
+
+#define SCV_LOG_MAX_ARGS 4
+#define SCV_LOG_LINE_SIZE 1024
+
+// drain thread is woken only when a ring gets this full, everything below
+// waits for its next periodic drain
+#ifndef SCV_LOG_WAKE_FILL
+#define SCV_LOG_WAKE_FILL (SCV_LOG_RING_SIZE / 4)
+#endif
+
+#ifndef SCV_LOG_DRAIN_INTERVAL_MS
+#define SCV_LOG_DRAIN_INTERVAL_MS 100
+#endif
+
+enum SCVLogOverflow {
+  SCV_LOG_OVERFLOW_DROP = 0, // drop record silently
+  SCV_LOG_OVERFLOW_BLOCK,    // wait until drain thread frees space
+  SCV_LOG_OVERFLOW_COUNT,    // drop record and report how many were dropped
+};
+
+typedef struct SCVLogRecord SCVLogRecord;
+struct SCVLogRecord {
+  u64  timestamp; // scvCntVct
+  char *tag;
+  char *msg;
+  char *filename;
+  u32  line;
+  u32  logitem;
+  u32  level;
+  u32  argc;
+  u64  args[SCV_LOG_MAX_ARGS];
+};
+
+typedef struct SCVLogRing SCVLogRing;
+struct SCVLogRing {
+  u64          head; // written by producer thread
+  u8           pad0[scvCacheLineSize - sizeof(u64)];
+  u64          tail; // written by drain thread
+  u8           pad1[scvCacheLineSize - sizeof(u64)];
+  u64          dropped;
+  u64          reported;
+  u64          drained; // formatted, becomes tail once it is written
+  u32          owned;   // 0 after owner thread exits, next new thread takes ring
+  SCVLogRing   *next;
+  SCVLogRecord records[SCV_LOG_RING_SIZE];
+};
+
+typedef struct SCVLogDesc SCVLogDesc;
+struct SCVLogDesc {
+  enum SCVLogOverflow overflow;
+  i32                 fd; // 0 means stderr
+};
+
+typedef struct SCVLogger SCVLogger;
+struct SCVLogger {
+  SCVLogRing      *rings;
+  u32             running;
+  u32             asleep;
+  u32             overflow;
+  i32             fd;
+  u64             startTime;
+  u64             freq;
+  SCVThread       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  u32             arenaLock;
+  SCVArena        arena;
+  u8              batch[SCV_LOG_BATCH_SIZE];
+};
+
+SCVLogger scvLogger = {0};
+scvThreadLocal SCVLogRing *scvLogThreadRing = nil;
+pthread_key_t  scvLogRingKey;
+pthread_once_t scvLogRingKeyOnce = PTHREAD_ONCE_INIT;
+
+// runs on thread exit, ring keeps its records for drain thread
+void
+scvLogRingRelease(void *ring)
+{
+  scvAtomicStore(&((SCVLogRing *)ring)->owned, 0u);
+}
+
+void
+scvLogRingKeyInit(void)
+{
+  scvAssert(pthread_key_create(&scvLogRingKey, scvLogRingRelease) == 0);
+}
+
+char*
+scvLogLevelName(u32 level)
+{
+  switch (level) {
+    case SCV_LOG_PANIC: return "panic";
+    case SCV_LOG_ERROR: return "error";
+    case SCV_LOG_WARN:  return "warn";
+    default:            return "info";
+  }
+}
+
+u64
+scvLogFormat(SCVLogRecord *r, SCVSlice s)
+{
+  u64 n = 0, i;
+
+  n += scvSlicePutCString(scvSliceLeft(s, n), "[");
+  n += scvSlicePutCString(scvSliceLeft(s, n), r->tag);
+  n += scvSlicePutCString(scvSliceLeft(s, n), "]");
+
+  n += scvSlicePutCString(scvSliceLeft(s, n), "[");
+  n += scvSlicePutCString(scvSliceLeft(s, n), scvLogLevelName(r->level));
+  n += scvSlicePutCString(scvSliceLeft(s, n), "]");
+
+  if (r->logitem > 0) {
+    n += scvSlicePutCString(scvSliceLeft(s, n), "[id:");
+    n += scvSlicePutU64(scvSliceLeft(s, n), (u64)r->logitem);
+    n += scvSlicePutCString(scvSliceLeft(s, n), "]");
+  }
+
+  if (r->timestamp && scvLogger.freq) {
+    n += scvSlicePutCString(scvSliceLeft(s, n), "[us:");
+    n += scvSlicePutU64(scvSliceLeft(s, n),
+        (u64)((f64)(r->timestamp - scvLogger.startTime) * 1000000.0 / (f64)scvLogger.freq));
+    n += scvSlicePutCString(scvSliceLeft(s, n), "]");
+  }
+
+  if (r->filename) {
+    // gcc/clang compiler error format
+    n += scvSlicePutCString(scvSliceLeft(s, n), " ");
+    n += scvSlicePutCString(scvSliceLeft(s, n), r->filename);
+    n += scvSlicePutCString(scvSliceLeft(s, n), ":");
+    n += scvSlicePutU64(scvSliceLeft(s, n), (u64)r->line);
+    n += scvSlicePutCString(scvSliceLeft(s, n), ":0:");
+  } else {
+    n += scvSlicePutCString(scvSliceLeft(s, n), "[line:");
+    n += scvSlicePutU64(scvSliceLeft(s, n), (u64)r->line);
+    n += scvSlicePutCString(scvSliceLeft(s, n), "]");
+  }
+
+  if (r->msg) {
+    n += scvSlicePutCString(scvSliceLeft(s, n), "\n\t");
+    n += scvSlicePutCString(scvSliceLeft(s, n), r->msg);    
+  }
+  for (i = 0; i < r->argc; ++i) {
+    n += scvSlicePutCString(scvSliceLeft(s, n), " ");
+    n += scvSlicePutU64(scvSliceLeft(s, n), r->args[i]);
+  }
+  n += scvSlicePutCString(scvSliceLeft(s, n), "\n\n");
+
+  if (r->level == SCV_LOG_PANIC) {
+    n += scvSlicePutCString(scvSliceLeft(s, n), "ABORTING because of [panic]\n");
+  }
+
+  return n;
+}
+
+void
+scvLogWriteSync(SCVLogRecord *r)
+{
+  u8 linebuf[SCV_LOG_LINE_SIZE];
+  SCVSlice s = scvUnsafeSlice(linebuf, sizeof(linebuf));
+  u64 n = scvLogFormat(r, s);
+
+  scvWrite(scvLogger.fd ? scvLogger.fd : 2, linebuf, n, nil);
+}
+
+bool
+scvLogRingsEmpty(void)
+{
+  SCVLogRing *ring;
+
+  for (ring = scvAtomicLoad(&scvLogger.rings); ring; ring = ring->next) {
+    if (scvAtomicLoad(&ring->head) != scvAtomicLoad(&ring->tail)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// formats everything which is in rings now, returns false if nothing was there
+bool
+scvLogDrain(void)
+{
+  SCVLogRing *ring, *first;
+  SCVLogRecord dropped = {0};
+  SCVSlice batch = scvUnsafeSlice(scvLogger.batch, sizeof(scvLogger.batch));
+  u64 n = 0, head, tail, count;
+  i32 fd = scvLogger.fd ? scvLogger.fd : 2;
+  bool any = false;
+
+  first = scvAtomicLoad(&scvLogger.rings);
+  for (ring = first; ring; ring = ring->next) {
+    head = scvAtomicLoad(&ring->head);
+    tail = scvAtomicLoadRelaxed(&ring->tail);
+    for (; tail != head; ++tail) {
+      if (n + SCV_LOG_LINE_SIZE > batch.len) {
+        scvWrite(fd, batch.base, n, nil);
+        n = 0;
+      }
+      n += scvLogFormat(&ring->records[tail & (SCV_LOG_RING_SIZE - 1)],
+          scvSliceRight(scvSliceLeft(batch, n), SCV_LOG_LINE_SIZE));
+      any = true;
+    }
+    ring->drained = tail;
+
+    count = scvAtomicLoadRelaxed(&ring->dropped);
+    if (count != ring->reported) {
+      dropped.tag = "log";
+      dropped.level = SCV_LOG_WARN;
+      dropped.msg = "records dropped because ring buffer was full:";
+      dropped.argc = 1;
+      dropped.args[0] = count - ring->reported;
+      ring->reported = count;
+      if (n + SCV_LOG_LINE_SIZE > batch.len) {
+        scvWrite(fd, batch.base, n, nil);
+        n = 0;
+      }
+      n += scvLogFormat(&dropped, scvSliceRight(scvSliceLeft(batch, n), SCV_LOG_LINE_SIZE));
+    }
+  }
+
+  if (n > 0) {
+    scvWrite(fd, batch.base, n, nil);
+  }
+  // tail moves only after records are written, so flush can't return early
+  for (ring = first; ring; ring = ring->next) {
+    scvAtomicStore(&ring->tail, ring->drained);
+  }
+
+  return any;
+}
+
+void*
+scvLogThreadProc(void *arg)
+{
+  (void)arg;
+
+  while (scvAtomicLoad(&scvLogger.running)) {
+    if (scvLogDrain()) {
+      continue;
+    }
+
+    pthread_mutex_lock(&scvLogger.mutex);
+    __atomic_store_n(&scvLogger.asleep, 1u, __ATOMIC_SEQ_CST);
+    if (scvLogRingsEmpty() && scvAtomicLoad(&scvLogger.running)) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += SCV_LOG_DRAIN_INTERVAL_MS * 1000000l;
+      deadline.tv_sec += deadline.tv_nsec / 1000000000l;
+      deadline.tv_nsec %= 1000000000l;
+      pthread_cond_timedwait(&scvLogger.cond, &scvLogger.mutex, &deadline);
+    }
+    __atomic_store_n(&scvLogger.asleep, 0u, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&scvLogger.mutex);
+  }
+
+  scvLogDrain();
+
+  return nil;
+}
+
+void
+scvLogWake(void)
+{
+  if (__atomic_load_n(&scvLogger.asleep, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&scvLogger.mutex);
+    pthread_cond_signal(&scvLogger.cond);
+    pthread_mutex_unlock(&scvLogger.mutex);
+  }
+}
+
+void
+scvLogStart(SCVLogDesc *desc)
+{
+  SCVError error = {0};
+
+  scvAssert(!scvLogger.running);
+  scvLogger.overflow = desc->overflow;
+  scvLogger.fd = desc->fd;
+  scvLogger.freq = scvCntFrq();
+  scvLogger.startTime = scvCntVct();
+
+  if (scvLogger.arena.buf == nil) {
+    scvArenaInitReserve(&scvLogger.arena, (u64)1 << 30, &error);
+    if (error.tag) {
+      scvFatalError("can't reserve log arena", &error);
+    }
+    scvLogger.arena.tag = SCV_MEM_TAG_LOG;
+  }
+
+  pthread_mutex_init(&scvLogger.mutex, nil);
+  pthread_cond_init(&scvLogger.cond, nil);
+  scvAtomicStore(&scvLogger.running, 1u);
+  if (!scvThreadCreate(&scvLogger.thread, scvLogThreadProc, nil)) {
+    scvAtomicStore(&scvLogger.running, 0u);
+    scvWarn("log", "can't start log thread, logging synchronously");
+  }
+}
+
+// waits until everything logged so far is written
+void
+scvLogFlush(void)
+{
+  while (scvAtomicLoad(&scvLogger.running) && !scvLogRingsEmpty()) {
+    scvLogWake();
+    scvThreadYield();
+  }
+}
+
+void
+scvLogStop(void)
+{
+  if (!scvAtomicLoad(&scvLogger.running)) {
+    return;
+  }
+  scvAtomicStore(&scvLogger.running, 0u);
+  pthread_mutex_lock(&scvLogger.mutex);
+  pthread_cond_signal(&scvLogger.cond);
+  pthread_mutex_unlock(&scvLogger.mutex);
+  scvThreadJoin(scvLogger.thread);
+}
+
+SCVLogRing*
+scvLogGetThreadRing(void)
+{
+  SCVLogRing *ring = scvLogThreadRing;
+  u32 expected = 0;
+
+  if (ring) {
+    return ring;
+  }
+  pthread_once(&scvLogRingKeyOnce, scvLogRingKeyInit);
+
+  // NOTE: rings live until exit, drain thread walks list without locks.
+  // Ring of exited thread is taken over as is, so list stays as long as
+  // most threads logging at once.
+  for (ring = scvAtomicLoad(&scvLogger.rings); ring; ring = ring->next) {
+    if (scvAtomicCASStrong(&ring->owned, &expected, 1u)) {
+      break;
+    }
+    expected = 0;
+  }
+
+  if (!ring) {
+    while (!scvAtomicCAS(&scvLogger.arenaLock, &expected, 1u)) {
+      expected = 0;
+    }
+    ring = scvArenaAllocAlign(&scvLogger.arena, sizeof(SCVLogRing), nil, scvCacheLineSize);
+    scvAtomicStore(&scvLogger.arenaLock, 0u);
+    scvAssert(ring);
+    ring->owned = 1;
+
+    ring->next = scvAtomicLoadRelaxed(&scvLogger.rings);
+    while (!scvAtomicCAS(&scvLogger.rings, &ring->next, ring)) {}
+  }
+  pthread_setspecific(scvLogRingKey, ring);
+  scvLogThreadRing = ring;
+
+  return ring;
+}
+
+void
+scvLogArgs(
+    char *tag,
+    enum SCVLogLevel level,
+    u32 logitem,
+    char* msg,
+    u32 line,
+    char* filename,
+    u32 argc,
+    u64 *args
+) {
+  SCVLogRecord *r;
+  SCVLogRecord record;
+  SCVLogRing *ring;
+  u64 head, tail, i;
+
+  argc = scvMin(argc, SCV_LOG_MAX_ARGS);
+
+  if (level == SCV_LOG_PANIC || !scvAtomicLoadRelaxed(&scvLogger.running)) {
+    record.timestamp = scvLogger.freq ? scvCntVct() : 0;
+    record.tag = tag;
+    record.msg = msg;
+    record.filename = filename;
+    record.line = line;
+    record.logitem = logitem;
+    record.level = level;
+    record.argc = argc;
+    for (i = 0; i < argc; ++i) {
+      record.args[i] = args[i];
+    }
+    scvLogFlush();
+    scvLogWriteSync(&record);
+    if (level == SCV_LOG_PANIC) {
+      scvBreakpoint;
+    }
+    return;
+  }
+
+  ring = scvLogGetThreadRing();
+  head = scvAtomicLoadRelaxed(&ring->head);
+  while (head - (tail = scvAtomicLoad(&ring->tail)) >= SCV_LOG_RING_SIZE) {
+    if (scvLogger.overflow != SCV_LOG_OVERFLOW_BLOCK) {
+      if (scvLogger.overflow == SCV_LOG_OVERFLOW_COUNT) {
+        scvAtomicStoreRelaxed(&ring->dropped, ring->dropped + 1);
+      }
+      scvLogWake();
+      return;
+    }
+    scvLogWake();
+    scvThreadYield();
+  }
+
+  r = &ring->records[head & (SCV_LOG_RING_SIZE - 1)];
+  r->timestamp = scvCntVct();
+  r->tag = tag;
+  r->msg = msg;
+  r->filename = filename;
+  r->line = line;
+  r->logitem = logitem;
+  r->level = level;
+  r->argc = argc;
+  for (i = 0; i < argc; ++i) {
+    r->args[i] = args[i];
+  }
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+
+  // sparse records don't touch mutex, periodic drain picks them up
+  if (head + 1 - tail >= SCV_LOG_WAKE_FILL) {
+    scvLogWake();
+  }
+}
+
+void 
+scvLog(
+    char *tag,
+    enum SCVLogLevel level,
+    u32 logitem,
+    char* msg,
+    u32 line,
+    char* filename
+) {
+  scvLogArgs(tag, level, logitem, msg, line, filename, 0, nil);
+}
+
+// files
+
+// mapped read only and private, fd is closed right after mmap
+
+enum SCVFileAccess {
+  SCV_FILE_ACCESS_NORMAL = 0,
+  SCV_FILE_ACCESS_SEQUENTIAL,
+  SCV_FILE_ACCESS_RANDOM,
+};
+
+typedef struct SCVFileMapDesc SCVFileMapDesc;
+struct SCVFileMapDesc {
+  enum SCVFileAccess access;
+  bool               populate;
+};
+
+typedef struct SCVMappedFile SCVMappedFile;
+struct SCVMappedFile {
+  u8  *base;
+  u64 len;
+};
+
+void
+scvMadvise(void *addr, u64 len, i32 advice, SCVError *error)
+{
+  SCVSyscallResult r = scvSyscall(SYS_madvise, (uptr)addr, (uptr)len, (uptr)advice);
+  scvErrorSet(error, "madvise failed with code", r.err);
+}
+
+i32
+scvFileAccessAdvice(enum SCVFileAccess access)
+{
+  switch (access) {
+    case SCV_FILE_ACCESS_SEQUENTIAL: return MADV_SEQUENTIAL;
+    case SCV_FILE_ACCESS_RANDOM:     return MADV_RANDOM;
+    default:                         return MADV_NORMAL;
+  }
+}
+
+// desc can be nil. Empty file gives empty mapping without error
+SCVMappedFile
+scvMapFile(SCVString pathname, SCVFileMapDesc *desc, SCVError *error)
+{
+  SCVFileMapDesc def = {0};
+  SCVMappedFile file = {0};
+  struct stat filestat = {0};
+  SCVError err = {0};
+  i32 fd, flags = MAP_PRIVATE;
+  void *buf;
+
+  if (!desc) {
+    desc = &def;
+  }
+
+  scvZoneBegin("scvMapFile");
+  fd = scvOpen(pathname, O_RDONLY, &err);
+  if (err.tag) {
+    goto done;
+  }
+
+  scvFStat(fd, &filestat, &err);
+  if (err.tag || filestat.st_size == 0) {
+    scvClose(fd);
+    goto done;
+  }
+
+#ifdef MAP_POPULATE
+  if (desc->populate) {
+    flags |= MAP_POPULATE;
+  }
+#endif
+  buf = scvMmap(nil, (u64)filestat.st_size, PROT_READ, flags, fd, 0, &err);
+  scvClose(fd);
+  if (!buf) {
+    goto done;
+  }
+
+  file.base = buf;
+  file.len = (u64)filestat.st_size;
+
+  // hints are best effort, failure is not an error for caller
+  if (desc->access != SCV_FILE_ACCESS_NORMAL) {
+    scvMadvise(file.base, file.len, scvFileAccessAdvice(desc->access), nil);
+  }
+#ifndef MAP_POPULATE
+  if (desc->populate) {
+    scvMadvise(file.base, file.len, MADV_WILLNEED, nil);
+  }
+#endif
+
+done:
+  scvZoneEnd();
+  if (error && err.tag) {
+    *error = err;
+  }
+  return file;
+}
+
+void
+scvUnmapFile(SCVMappedFile *file)
+{
+  if (file->base) {
+    scvMunmap(file->base, file->len, nil);
+  }
+  file->base = nil;
+  file->len = 0;
+}
+
+SCVSlice
+scvLoadFile(SCVString pathname, SCVError *error)
+{
+  SCVMappedFile file = scvMapFile(pathname, nil, error);
+
+  return scvUnsafeSlice(file.base, file.len);
+}
+
+void
+scvUnloadFile(SCVSlice sl)
+{
+  if (sl.base) {
+    scvSliceMunmap(sl);
+  }
+}
+
+// streaming reader
+
+typedef struct SCVFileReader SCVFileReader;
+struct SCVFileReader {
+  i32      fd;
+  u8       *buf;
+  u64      cap;
+  u64      offset; // file offset of the next chunk
+  bool     eof;
+  SCVError err;
+};
+
+// buffer is owned by caller and reused for every chunk
+bool
+scvFileReaderOpen(SCVFileReader *reader, SCVString pathname, SCVSlice buffer, SCVError *error)
+{
+  scvClear(reader, sizeof(*reader));
+  scvAssert(buffer.len > 0);
+  reader->buf = buffer.base;
+  reader->cap = buffer.len;
+
+  reader->fd = scvOpen(pathname, O_RDONLY, &reader->err);
+  if (reader->err.tag) {
+    reader->fd = -1;
+    reader->eof = true;
+    if (error) {
+      *error = reader->err;
+    }
+    return false;
+  }
+
+#if defined(__linux__)
+  // tell page cache to read ahead aggressively, best effort
+  scvSyscall6(SYS_fadvise64, (uptr)reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL, 0, 0);
+#endif
+
+  return true;
+}
+
+// next chunk of file in reader buffer, valid until next call.
+// Returns empty string on end of file or error (see reader->err)
+SCVString
+scvFileReaderNext(SCVFileReader *reader)
+{
+  SCVString chunk = {0};
+  i64 n = 0;
+
+  if (reader->eof) {
+    return chunk;
+  }
+
+  scvZoneBegin("scvFileReaderNext");
+  while (chunk.len < reader->cap) {
+    n = scvRead(reader->fd, scvUnsafeSlice(reader->buf + chunk.len, reader->cap - chunk.len), &reader->err);
+    if (reader->err.tag || n <= 0) {
+      reader->eof = true;
+      break;
+    }
+    chunk.len += (u64)n;
+  }
+
+  chunk.base = reader->buf;
+  reader->offset += chunk.len;
+  scvZoneEnd();
+
+  return chunk;
+}
+
+void
+scvFileReaderClose(SCVFileReader *reader)
+{
+  if (reader->fd >= 0) {
+    scvClose(reader->fd);
+  }
+  reader->fd = -1;
+  reader->eof = true;
+}
+
+// pool allocator
+
+typedef struct SCVPoolFreeNode SCVPoolFreeNode;
+struct SCVPoolFreeNode {
+  SCVPoolFreeNode *next;
+};
+
+typedef struct SCVPool SCVPool;
+struct SCVPool {
+  u8              *buf;
+  u64             len;
+  u64             chunkSize;
+  SCVPoolFreeNode *head;
+  u64             used; // bytes in allocated chunks
+  u32             tag;  // enum SCVMemTag of all chunks
+#ifdef SCV_MEM_STATS
+  SCVMemStats     stats;
+#endif
+};
+
+void 
+scvPoolFreeAll(SCVPool *pool)
+{
+  u64 chunkCount;
+  u64 i;
+
+  chunkCount = pool->len / pool->chunkSize;
+
+  for (i = 0; i < chunkCount; i++) {
+    void *ptr = &pool->buf[i * pool->chunkSize];
+    SCVPoolFreeNode *node = (SCVPoolFreeNode *)ptr;
+    node->next = pool->head;
+    pool->head = node;
+  }
+
+  pool->used = 0;
+}
+
+#define scvPoolInitDefault(p, m, size) scvPoolInit((p), (m), (size), SCV_DEFAULT_ALIGNMENT);
+
+void
+scvPoolInit(SCVPool *pool, SCVSlice mem, u64 chunkSize, u64 chunkAlignment)
+{
+  scvAssert(pool);
+  scvAssert(mem.base != nil && mem.cap > 0);
+  uptr initialStart = (uptr)mem.base;
+  uptr start = scvAlignForward(initialStart, chunkAlignment);
+
+  u64 len = mem.cap - (u64)(start - initialStart);
+  chunkSize = (u64)scvAlignForward((uptr)chunkSize, chunkAlignment);
+
+  scvAssert(chunkSize >= sizeof(SCVPoolFreeNode));
+  scvAssert(len >= chunkSize);
+
+  pool->buf = (u8 *)mem.base;
+  pool->len = len;
+  pool->chunkSize = chunkSize;
+  pool->head = nil;
+  pool->tag = SCV_MEM_TAG_NONE;
+#ifdef SCV_MEM_STATS
+  scvClear(&pool->stats, sizeof(pool->stats));
+#endif
+
+  scvPoolFreeAll(pool);
+}
+
+void*
+scvPoolAlloc(SCVPool *pool)
+{
+  scvAssert(pool);
+  SCVPoolFreeNode *node = pool->head;
+  if (node == nil) {
+    scvAssert(node);
+    return nil;
+  }
+
+  pool->head = pool->head->next;
+  pool->used += pool->chunkSize;
+
+#ifdef SCV_MEM_STATS
+  pool->stats.allocCount++;
+  pool->stats.highWater = scvMax(pool->stats.highWater, pool->used);
+#endif
+
+  return memset(node, 0, pool->chunkSize);
+}
+
+void
+scvPoolFree(SCVPool *pool, void *ptr)
+{
+  SCVPoolFreeNode *node;
+
+  void *start = pool->buf;
+  void *end   = &pool->buf[pool->len];
+  if (ptr == nil) {
+    return;
+  }
+
+  if (!(start <= ptr && ptr < end)) {
+    scvAssert(0);
+    return;
+  }
+
+  node = (SCVPoolFreeNode *)ptr;
+  node->next = pool->head;
+  pool->head = node;
+  pool->used -= pool->chunkSize;
+}
+
+// memory stats snapshots, cheap copies which can be taken every frame
+
+SCVMemStats
+scvArenaStats(SCVArena *arena)
+{
+  SCVMemStats stats = {0};
+
+#ifdef SCV_MEM_STATS
+  stats = arena->stats;
+#endif
+  stats.reserved  = arena->reserved;
+  stats.committed = arena->size;
+  stats.used      = arena->currOffset;
+
+  return stats;
+}
+
+SCVMemStats
+scvPoolStats(SCVPool *pool)
+{
+  SCVMemStats stats = {0};
+
+#ifdef SCV_MEM_STATS
+  stats = pool->stats;
+  stats.tagBytes[pool->tag] = pool->used;
+  stats.tagCount[pool->tag] = pool->used / pool->chunkSize;
+#endif
+  stats.reserved  = pool->len;
+  stats.committed = pool->len;
+  stats.used      = pool->used;
+
+  return stats;
+}
+
+void
+scvMemStatsAdd(SCVMemStats *dest, SCVMemStats *src)
+{
+  u64 i;
+
+  dest->reserved   += src->reserved;
+  dest->committed  += src->committed;
+  dest->used       += src->used;
+  dest->highWater  += src->highWater;
+  dest->allocCount += src->allocCount;
+  for (i = 0; i < SCV_MEM_TAG_COUNT; ++i) {
+    dest->tagBytes[i] += src->tagBytes[i];
+    dest->tagCount[i] += src->tagCount[i];
+  }
+}
+
+u64
+scvSlicePutMemStat(SCVSlice s, char *name, u64 value)
+{
+  u64 n = 0;
+
+  n += scvSlicePutCString(scvSliceLeft(s, n), " ");
+  n += scvSlicePutCString(scvSliceLeft(s, n), name);
+  n += scvSlicePutCString(scvSliceLeft(s, n), "=");
+  n += scvSlicePutU64(scvSliceLeft(s, n), value);
+
+  return n;
+}
+
+void
+scvPrintMemStats(char *name, SCVMemStats *stats)
+{
+  u8 linebuf[1024];
+  u64 n = 0;
+  SCVSlice s = scvUnsafeSlice(linebuf, sizeof(linebuf));
+#ifdef SCV_MEM_STATS
+  u64 i;
+#endif
+
+  n += scvSlicePutCString(scvSliceLeft(s, n), "[mem][");
+  n += scvSlicePutCString(scvSliceLeft(s, n), name);
+  n += scvSlicePutCString(scvSliceLeft(s, n), "]");
+  n += scvSlicePutMemStat(scvSliceLeft(s, n), "reserved", stats->reserved);
+  n += scvSlicePutMemStat(scvSliceLeft(s, n), "committed", stats->committed);
+  n += scvSlicePutMemStat(scvSliceLeft(s, n), "used", stats->used);
+#ifdef SCV_MEM_STATS
+  n += scvSlicePutMemStat(scvSliceLeft(s, n), "highwater", stats->highWater);
+  n += scvSlicePutMemStat(scvSliceLeft(s, n), "allocs", stats->allocCount);
+
+  for (i = 0; i < SCV_MEM_TAG_COUNT; ++i) {
+    if (stats->tagCount[i] == 0) {
+      continue;
+    }
+    n += scvSlicePutCString(scvSliceLeft(s, n), "\n\t");
+    n += scvSlicePutCString(scvSliceLeft(s, n), scvMemTagNames[i]);
+    n += scvSlicePutMemStat(scvSliceLeft(s, n), "bytes", stats->tagBytes[i]);
+    n += scvSlicePutMemStat(scvSliceLeft(s, n), "allocs", stats->tagCount[i]);
+  }
+#endif
+
+  scvPrintString(scvString(scvSliceRight(s, n)));
+}
+
+// slab pool with generational handles
+
+// handles are slot index | generation << SCV_HANDLE_INDEX_BITS, generation is
+// bumped on free so stale handle gets nil. Slabs never move once published,
+// free list is generation tagged Treiber stack, growing takes spinlock.
+
+typedef u32 SCVHandle;
+
+#define SCV_HANDLE_NIL        0
+#define SCV_HANDLE_INDEX_BITS 20
+#define SCV_HANDLE_INDEX_MASK ((1u << SCV_HANDLE_INDEX_BITS) - 1)
+#define SCV_HANDLE_GEN_MASK   ((1u << (32 - SCV_HANDLE_INDEX_BITS)) - 1)
+#define SCV_SLAB_MAX          SCV_HANDLE_INDEX_BITS
+#define SCV_SLAB_SLOT_NIL     0xffffffffu
+#define SCV_SLAB_SLOT_ALIVE   0xfffffffeu
+
+#define scvHandleIndex(h) ((h) & SCV_HANDLE_INDEX_MASK)
+#define scvHandleGen(h)   ((h) >> SCV_HANDLE_INDEX_BITS)
+
+typedef struct SCVSlabSlot SCVSlabSlot;
+struct SCVSlabSlot {
+  u32 gen;  // never 0, so SCV_HANDLE_NIL never matches
+  u32 next; // next free slot or SCV_SLAB_SLOT_ALIVE
+};
+
+typedef struct SCVSlab SCVSlab;
+struct SCVSlab {
+  u8          *chunks;
+  SCVSlabSlot *slots;
+};
+
+typedef struct SCVSlabPool SCVSlabPool;
+struct SCVSlabPool {
+  u64      head;
+  u8       pad[scvCacheLineSize - sizeof(u64)];
+  u32      lock;
+  u32      slabCount;
+  u32      slabBase;
+  u32      tag; // enum SCVMemTag of all chunks
+  u64      chunkSize;
+  u64      chunkAlignment;
+  u64      used;
+  SCVSlab  slabs[SCV_SLAB_MAX];
+  SCVArena arena;
+};
+
+#define scvSlabPoolInitDefault(p, size, initial, err) \
+  scvSlabPoolInit((p), (size), SCV_DEFAULT_ALIGNMENT, (initial), (err))
+
+void
+scvSlabPoolInit(SCVSlabPool *pool, u64 chunkSize, u64 chunkAlignment, u32 initialCount, SCVError *err)
+{
+  u64 slabBase = 1;
+  u64 maxCount;
+
+  scvAssert(pool);
+  scvClear(pool, sizeof(SCVSlabPool));
+
+  while (slabBase < initialCount) {
+    slabBase <<= 1;
+  }
+  scvAssert(slabBase <= SCV_HANDLE_INDEX_MASK);
+
+  pool->chunkSize = (u64)scvAlignForward((uptr)chunkSize, chunkAlignment);
+  pool->chunkAlignment = chunkAlignment;
+  pool->slabBase = (u32)slabBase;
+  pool->head = SCV_SLAB_SLOT_NIL;
+
+  // reserve enough address space for every slab pool can ever have
+  maxCount = (u64)SCV_HANDLE_INDEX_MASK + 1;
+  scvArenaInitReserve(&pool->arena,
+      2 * maxCount * (pool->chunkSize + sizeof(SCVSlabSlot)) + SCV_SLAB_MAX * 2 * chunkAlignment, err);
+}
+
+void
+scvSlabPoolRelease(SCVSlabPool *pool)
+{
+  scvArenaRelease(&pool->arena);
+  scvClear(pool, sizeof(SCVSlabPool));
+}
+
+u32
+scvSlabFind(SCVSlabPool *pool, u32 index, u32 *slabIndex)
+{
+  u32 k;
+  u64 q = (u64)index / pool->slabBase + 1;
+
+  k = 63 - (u32)__builtin_clzll(q);
+  *slabIndex = index - pool->slabBase * ((1u << k) - 1);
+
+  return k;
+}
+
+SCVSlabSlot*
+scvSlabPoolSlot(SCVSlabPool *pool, u32 index)
+{
+  u32 k, i;
+
+  k = scvSlabFind(pool, index, &i);
+  return &pool->slabs[k].slots[i];
+}
+
+void*
+scvSlabPoolChunk(SCVSlabPool *pool, u32 index)
+{
+  u32 k, i;
+
+  k = scvSlabFind(pool, index, &i);
+  return pool->slabs[k].chunks + (u64)i * pool->chunkSize;
+}
+
+// adds one more slab, returns false when handle index space is exhausted
+bool
+scvSlabPoolGrow(SCVSlabPool *pool)
+{
+  u32 k, i, first, count, expected = 0;
+  u64 head, newhead;
+  SCVSlab slab;
+  SCVError error = {0};
+  bool result = true;
+
+  while (!scvAtomicCAS(&pool->lock, &expected, 1u)) {
+    expected = 0;
+  }
+
+  // somebody else already grew the pool while we waited
+  if ((u32)scvAtomicLoad(&pool->head) != SCV_SLAB_SLOT_NIL) {
+    scvAtomicStore(&pool->lock, 0u);
+    return true;
+  }
+
+  k = pool->slabCount;
+  count = pool->slabBase << k;
+  first = pool->slabBase * ((1u << k) - 1);
+  if (k >= SCV_SLAB_MAX || (u64)first + count > (u64)SCV_HANDLE_INDEX_MASK + 1) {
+    scvAtomicStore(&pool->lock, 0u);
+    return false;
+  }
+
+  pool->arena.tag = pool->tag;
+  slab.chunks = scvArenaAllocAlignNoZero(&pool->arena, (u64)count * pool->chunkSize, &error, pool->chunkAlignment);
+  slab.slots  = scvArenaAllocAlignNoZero(&pool->arena, (u64)count * sizeof(SCVSlabSlot), &error, sizeof(u64));
+  if (error.tag) {
+    result = false;
+  } else {
+    for (i = 0; i < count; ++i) {
+      slab.slots[i].gen  = 1;
+      slab.slots[i].next = first + i + 1;
+    }
+    pool->slabs[k] = slab;
+    scvAtomicStore(&pool->slabCount, k + 1);
+
+    head = scvAtomicLoadRelaxed(&pool->head);
+    do {
+      scvAtomicStoreRelaxed(&slab.slots[count - 1].next, (u32)head);
+      newhead = (((head >> 32) + 1) << 32) | (u64)first;
+    } while (!scvAtomicCAS(&pool->head, &head, newhead));
+  }
+
+  scvAtomicStore(&pool->lock, 0u);
+  return result;
+}
+
+SCVHandle
+scvSlabPoolAlloc(SCVSlabPool *pool, void **out)
+{
+  u64 head, newhead;
+  u32 index;
+  SCVSlabSlot *slot;
+  void *ptr;
+
+  scvAssert(pool);
+  head = scvAtomicLoad(&pool->head);
+  for (;;) {
+    index = (u32)head;
+    if (index == SCV_SLAB_SLOT_NIL) {
+      if (!scvSlabPoolGrow(pool)) {
+        scvAssert(0 && "slab pool exhausted");
+        return SCV_HANDLE_NIL;
+      }
+      head = scvAtomicLoad(&pool->head);
+      continue;
+    }
+    slot = scvSlabPoolSlot(pool, index);
+    newhead = (((head >> 32) + 1) << 32) | (u64)scvAtomicLoadRelaxed(&slot->next);
+    if (scvAtomicCAS(&pool->head, &head, newhead)) {
+      break;
+    }
+  }
+
+  scvAtomicStoreRelaxed(&slot->next, SCV_SLAB_SLOT_ALIVE);
+  scvAtomicAddRelaxed(&pool->used, 1);
+
+  ptr = memset(scvSlabPoolChunk(pool, index), 0, pool->chunkSize);
+  if (out) {
+    *out = ptr;
+  }
+
+  return (scvAtomicLoadRelaxed(&slot->gen) << SCV_HANDLE_INDEX_BITS) | index;
+}
+
+// returns nil for SCV_HANDLE_NIL, stale or freed handle
+void*
+scvSlabPoolGet(SCVSlabPool *pool, SCVHandle handle)
+{
+  u32 index = scvHandleIndex(handle);
+  SCVSlabSlot *slot;
+
+  if (handle == SCV_HANDLE_NIL || index >= pool->slabBase * ((1u << scvAtomicLoad(&pool->slabCount)) - 1)) {
+    return nil;
+  }
+
+  slot = scvSlabPoolSlot(pool, index);
+  if (scvAtomicLoadRelaxed(&slot->gen) != scvHandleGen(handle) ||
+      scvAtomicLoadRelaxed(&slot->next) != SCV_SLAB_SLOT_ALIVE) {
+    return nil;
+  }
+
+  return scvSlabPoolChunk(pool, index);
+}
+
+bool
+scvSlabPoolIsValid(SCVSlabPool *pool, SCVHandle handle)
+{
+  return scvSlabPoolGet(pool, handle) != nil;
+}
+
+void
+scvSlabPoolFree(SCVSlabPool *pool, SCVHandle handle)
+{
+  u64 head, newhead;
+  u32 gen, index = scvHandleIndex(handle);
+  SCVSlabSlot *slot;
+
+  if (!scvSlabPoolIsValid(pool, handle)) {
+    scvAssert(handle == SCV_HANDLE_NIL);
+    return;
+  }
+
+  slot = scvSlabPoolSlot(pool, index);
+  gen = (scvAtomicLoadRelaxed(&slot->gen) + 1) & SCV_HANDLE_GEN_MASK;
+  scvAtomicStoreRelaxed(&slot->gen, gen == 0 ? 1 : gen);
+  scvAtomicAddRelaxed(&pool->used, (u64)-1);
+
+  head = scvAtomicLoadRelaxed(&pool->head);
+  do {
+    scvAtomicStoreRelaxed(&slot->next, (u32)head);
+    newhead = (((head >> 32) + 1) << 32) | (u64)index;
+  } while (!scvAtomicCAS(&pool->head, &head, newhead));
+}
+
+SCVMemStats
+scvSlabPoolStats(SCVSlabPool *pool)
+{
+  SCVMemStats stats = scvArenaStats(&pool->arena);
+  u64 used = scvAtomicLoadRelaxed(&pool->used);
+
+  scvClear(stats.tagBytes, sizeof(stats.tagBytes));
+  scvClear(stats.tagCount, sizeof(stats.tagCount));
+  stats.tagBytes[pool->tag] = used * pool->chunkSize;
+  stats.tagCount[pool->tag] = used;
+
+  return stats;
+}
+
+// hash
+
+// not cryptographic, only for hash tables
+
+u64
+scvHashU64(u64 x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ull;
+  x ^= x >> 33;
+
+  return x;
+}
+
+u64
+scvHashBytes(void *ptr, u64 len, u64 seed)
+{
+  u8 *p = ptr;
+  u64 h = seed ^ (len * 0x9e3779b97f4a7c15ull);
+  u64 k = 0;
+
+  while (len >= 8) {
+    memcpy(&k, p, 8);
+    h ^= k * 0xbf58476d1ce4e5b9ull;
+    h = ((h << 27) | (h >> 37)) * 0x94d049bb133111ebull;
+    p += 8;
+    len -= 8;
+  }
+  if (len) {
+    k = 0;
+    memcpy(&k, p, len);
+    h ^= k * 0xbf58476d1ce4e5b9ull;
+    h = ((h << 27) | (h >> 37)) * 0x94d049bb133111ebull;
+  }
+
+  return scvHashU64(h);
+}
+
+u64
+scvHashString(SCVString s)
+{
+  return scvHashBytes(s.base, s.len, 0);
+}
+
+// hash map
+
+// swiss table, string keys are not copied and must outlive map. Not thread safe.
+// Map only grows: old arrays stay in arena until reset, tombstones are
+// cleaned in place.
+
+#define SCV_MAP_GROUP     16
+#define SCV_MAP_EMPTY     0x80
+#define SCV_MAP_DELETED   0xfe
+
+typedef struct SCVMapEntry SCVMapEntry;
+struct SCVMapEntry {
+  u64 key; // key itself or full hash of string key
+  u64 value;
+};
+
+typedef struct SCVMap SCVMap;
+struct SCVMap {
+  u8          *ctrl;
+  SCVMapEntry *entries;
+  SCVString   *strings; // only for string keys
+  u64         cap;      // slots, power of two, multiple of SCV_MAP_GROUP
+  u64         len;
+  u64         deleted;
+  bool        stringKeys;
+  SCVArena    *arena;
+};
+
+// bit i set when ctrl[i] == b
+u32
+scvMapMatch(u8 *ctrl, u8 b)
+{
+#if defined(__SSE2__)
+  __m128i group = _mm_loadu_si128((__m128i *)ctrl);
+  return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)b)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  u8 weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+  uint8x16_t eq = vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(b));
+  uint8x16_t bits = vandq_u8(eq, vld1q_u8(weights));
+  return (u32)vaddv_u8(vget_low_u8(bits)) | ((u32)vaddv_u8(vget_high_u8(bits)) << 8);
+#else
+  u32 i, mask = 0;
+  for (i = 0; i < SCV_MAP_GROUP; ++i) {
+    mask |= (u32)(ctrl[i] == b) << i;
+  }
+  return mask;
+#endif
+}
+
+u64
+scvMapHash(SCVMap *map, u64 key, SCVString str)
+{
+  return map->stringKeys ? scvHashString(str) : scvHashU64(key);
+}
+
+void
+scvMapAllocSlots(SCVMap *map, u64 cap)
+{
+  map->cap = cap;
+  map->len = 0;
+  map->deleted = 0;
+  map->ctrl = scvArenaAllocAlignNoZero(map->arena, cap, nil, SCV_MAP_GROUP);
+  map->entries = scvArenaAllocNoZero(map->arena, cap * sizeof(SCVMapEntry));
+  scvAssert(map->ctrl && map->entries);
+  memset(map->ctrl, SCV_MAP_EMPTY, cap);
+  map->strings = nil;
+  if (map->stringKeys) {
+    map->strings = scvArenaAllocNoZero(map->arena, cap * sizeof(SCVString));
+    scvAssert(map->strings);
+  }
+}
+
+void
+scvMapInit(SCVMap *map, SCVArena *arena, u64 initialCap, bool stringKeys)
+{
+  u64 cap = SCV_MAP_GROUP;
+
+  scvClear(map, sizeof(*map));
+  map->arena = arena;
+  map->stringKeys = stringKeys;
+
+  // room for initialCap entries under load factor
+  while (cap - cap / 8 < initialCap) {
+    cap *= 2;
+  }
+  scvMapAllocSlots(map, cap);
+}
+
+// slot index of key or -1
+i64
+scvMapFindSlot(SCVMap *map, u64 hash, u64 key, SCVString str)
+{
+  u64 gmask = map->cap / SCV_MAP_GROUP - 1;
+  u64 g = (hash >> 7) & gmask;
+  u8 h2 = (u8)(hash & 0x7f);
+  u64 probe, slot;
+  u32 match;
+  SCVString *s;
+
+  if (map->stringKeys) {
+    key = hash;
+  }
+
+  for (probe = 1; probe <= gmask + 1; ++probe) {
+    u8 *ctrl = map->ctrl + g * SCV_MAP_GROUP;
+
+    match = scvMapMatch(ctrl, h2);
+    while (match) {
+      slot = g * SCV_MAP_GROUP + (u64)__builtin_ctz(match);
+      if (map->entries[slot].key == key) {
+        if (!map->stringKeys) {
+          return (i64)slot;
+        }
+        s = &map->strings[slot];
+        if (s->len == str.len && memcmp(s->base, str.base, str.len) == 0) {
+          return (i64)slot;
+        }
+      }
+      match &= match - 1;
+    }
+    if (scvMapMatch(ctrl, SCV_MAP_EMPTY)) {
+      return -1;
+    }
+    g = (g + probe) & gmask;
+  }
+
+  return -1;
+}
+
+// first empty or deleted slot on probe path, table always has one
+u64
+scvMapFreeSlot(SCVMap *map, u64 hash)
+{
+  u64 gmask = map->cap / SCV_MAP_GROUP - 1;
+  u64 g = (hash >> 7) & gmask;
+  u64 probe;
+  u32 match;
+
+  for (probe = 1;; ++probe) {
+    u8 *ctrl = map->ctrl + g * SCV_MAP_GROUP;
+
+    match = scvMapMatch(ctrl, SCV_MAP_EMPTY) | scvMapMatch(ctrl, SCV_MAP_DELETED);
+    if (match) {
+      return g * SCV_MAP_GROUP + (u64)__builtin_ctz(match);
+    }
+    g = (g + probe) & gmask;
+  }
+}
+
+// same capacity rehash without allocation: full slots are marked DELETED
+// (not placed yet), tombstones become EMPTY, then every unplaced entry goes
+// to the first free slot on its probe path, swapping with unplaced one there
+void
+scvMapDropDeleted(SCVMap *map)
+{
+  u64 i, slot, hash;
+  SCVMapEntry entry;
+  SCVString str;
+
+  for (i = 0; i < map->cap; ++i) {
+    map->ctrl[i] = map->ctrl[i] & 0x80 ? SCV_MAP_EMPTY : SCV_MAP_DELETED;
+  }
+
+  for (i = 0; i < map->cap; ++i) {
+    if (map->ctrl[i] != SCV_MAP_DELETED) {
+      continue;
+    }
+    hash = map->stringKeys ? map->entries[i].key : scvHashU64(map->entries[i].key);
+    slot = scvMapFreeSlot(map, hash);
+
+    // already in the first group probe would put it in
+    if (slot / SCV_MAP_GROUP == i / SCV_MAP_GROUP) {
+      map->ctrl[i] = (u8)(hash & 0x7f);
+      continue;
+    }
+
+    if (map->ctrl[slot] == SCV_MAP_EMPTY) {
+      map->entries[slot] = map->entries[i];
+      if (map->stringKeys) {
+        map->strings[slot] = map->strings[i];
+      }
+      map->ctrl[slot] = (u8)(hash & 0x7f);
+      map->ctrl[i] = SCV_MAP_EMPTY;
+    } else {
+      // unplaced entry there, swap and place it on next pass over i
+      entry = map->entries[slot];
+      map->entries[slot] = map->entries[i];
+      map->entries[i] = entry;
+      if (map->stringKeys) {
+        str = map->strings[slot];
+        map->strings[slot] = map->strings[i];
+        map->strings[i] = str;
+      }
+      map->ctrl[slot] = (u8)(hash & 0x7f);
+      --i;
+    }
+  }
+  map->deleted = 0;
+}
+
+void
+scvMapRehash(SCVMap *map, u64 cap)
+{
+  SCVMap old = *map;
+  u64 i, slot, hash;
+
+  if (cap == map->cap) {
+    scvMapDropDeleted(map);
+    return;
+  }
+
+  scvMapAllocSlots(map, cap);
+
+  for (i = 0; i < old.cap; ++i) {
+    if (old.ctrl[i] & 0x80) {
+      continue;
+    }
+    hash = old.stringKeys ? old.entries[i].key : scvHashU64(old.entries[i].key);
+    slot = scvMapFreeSlot(map, hash);
+    map->ctrl[slot] = (u8)(hash & 0x7f);
+    map->entries[slot] = old.entries[i];
+    if (map->stringKeys) {
+      map->strings[slot] = old.strings[i];
+    }
+  }
+  map->len = old.len;
+}
+
+// inserts key if it's not there yet, returns pointer to its value.
+// Pointer is valid until next insert
+u64*
+scvMapPutKey(SCVMap *map, u64 key, SCVString str, u64 value)
+{
+  u64 hash = scvMapHash(map, key, str);
+  i64 found = scvMapFindSlot(map, hash, key, str);
+  u64 slot;
+
+  if (found >= 0) {
+    map->entries[found].value = value;
+    return &map->entries[found].value;
+  }
+
+  if ((map->len + map->deleted + 1) > map->cap - map->cap / 8) {
+    // mostly tombstones: rehash in place size, otherwise grow
+    scvMapRehash(map, map->len * 2 >= map->cap - map->cap / 8 ? map->cap * 2 : map->cap);
+  }
+
+  slot = scvMapFreeSlot(map, hash);
+  if (map->ctrl[slot] == SCV_MAP_DELETED) {
+    map->deleted--;
+  }
+  map->ctrl[slot] = (u8)(hash & 0x7f);
+  map->entries[slot].key = map->stringKeys ? hash : key;
+  map->entries[slot].value = value;
+  if (map->stringKeys) {
+    map->strings[slot] = str;
+  }
+  map->len++;
+
+  return &map->entries[slot].value;
+}
+
+u64*
+scvMapGetKey(SCVMap *map, u64 key, SCVString str)
+{
+  i64 slot = scvMapFindSlot(map, scvMapHash(map, key, str), key, str);
+
+  return slot < 0 ? nil : &map->entries[slot].value;
+}
+
+bool
+scvMapRemoveKey(SCVMap *map, u64 key, SCVString str)
+{
+  i64 slot = scvMapFindSlot(map, scvMapHash(map, key, str), key, str);
+  u64 g;
+
+  if (slot < 0) {
+    return false;
+  }
+
+  // group which never was full can't be on anybody's probe path further,
+  // so slot can go straight back to empty
+  g = (u64)slot & ~(u64)(SCV_MAP_GROUP - 1);
+  if (scvMapMatch(map->ctrl + g, SCV_MAP_EMPTY)) {
+    map->ctrl[slot] = SCV_MAP_EMPTY;
+  } else {
+    map->ctrl[slot] = SCV_MAP_DELETED;
+    map->deleted++;
+  }
+  map->len--;
+
+  return true;
+}
+
+void
+scvMapClear(SCVMap *map)
+{
+  memset(map->ctrl, SCV_MAP_EMPTY, map->cap);
+  map->len = 0;
+  map->deleted = 0;
+}
+
+SCVString scvMapNoString = {0};
+
+#define scvMapGetU64(map, key)           scvMapGetKey((map), (key), scvMapNoString)
+#define scvMapPutU64(map, key, value)    scvMapPutKey((map), (key), scvMapNoString, (value))
+#define scvMapRemoveU64(map, key)        scvMapRemoveKey((map), (key), scvMapNoString)
+#define scvMapGetString(map, str)        scvMapGetKey((map), 0, (str))
+#define scvMapPutString(map, str, value) scvMapPutKey((map), 0, (str), (value))
+#define scvMapRemoveString(map, str)     scvMapRemoveKey((map), 0, (str))
+
+// string interner
+
+// ids are stable and never 0, strings are copied once with trailing zero
+
+typedef struct SCVInterner SCVInterner;
+struct SCVInterner {
+  SCVMap    map;     // string -> id
+  SCVString *strings; // id -> string
+  u64       cap;
+  u32       count;
+  SCVArena  *arena;
+};
+
+void
+scvInternerInit(SCVInterner *interner, SCVArena *arena, u64 initialCap)
+{
+  scvClear(interner, sizeof(*interner));
+  interner->arena = arena;
+  scvMapInit(&interner->map, arena, initialCap, true);
+  interner->cap = scvMax(initialCap + 1, 16);
+  interner->strings = scvArenaAllocNoZero(arena, interner->cap * sizeof(SCVString));
+  scvAssert(interner->strings);
+  interner->strings[0] = scvMapNoString;
+  interner->count = 1;
+}
+
+// id of string, 0 when it was never interned
+u32
+scvInternFind(SCVInterner *interner, SCVString s)
+{
+  u64 *id = scvMapGetString(&interner->map, s);
+
+  return id ? (u32)*id : 0;
+}
+
+u32
+scvIntern(SCVInterner *interner, SCVString s)
+{
+  u64 *found = scvMapGetString(&interner->map, s);
+  SCVString copy;
+  SCVString *strings;
+  u32 id;
+
+  if (found) {
+    return (u32)*found;
+  }
+
+  scvAssert(interner->count < 0xffffffffu);
+  if (interner->count == interner->cap) {
+    strings = scvArenaAllocNoZero(interner->arena, interner->cap * 2 * sizeof(SCVString));
+    scvAssert(strings);
+    memcpy(strings, interner->strings, interner->cap * sizeof(SCVString));
+    interner->strings = strings;
+    interner->cap *= 2;
+  }
+
+  copy.base = scvArenaAllocAlignNoZero(interner->arena, s.len + 1, nil, 1);
+  scvAssert(copy.base);
+  memcpy(copy.base, s.base, s.len);
+  copy.base[s.len] = 0;
+  copy.len = s.len;
+
+  id = interner->count++;
+  interner->strings[id] = copy;
+  scvMapPutString(&interner->map, copy, id);
+
+  return id;
+}
+
+SCVString
+scvInternGet(SCVInterner *interner, u32 id)
+{
+  scvAssert(id > 0 && id < interner->count);
+  return interner->strings[id];
+}
+
+// profiler
+
+// zones are compiled in only with SCV_PROFILE, zone name must be a string
+// literal. scvProfileReset only bumps epoch, threads drop their events at
+// next outermost zone begin and readers skip buffers of older epoch.
+
+#ifndef SCV_PROFILE_EVENTS
+#define SCV_PROFILE_EVENTS (1 << 20) // per thread
+#endif
+
+#define SCV_PROFILE_MAX_DEPTH 64
+
+typedef struct SCVProfileEvent SCVProfileEvent;
+struct SCVProfileEvent {
+  u64  ticks;
+  char *name; // nil for end
+};
+
+typedef struct SCVProfileBuffer SCVProfileBuffer;
+struct SCVProfileBuffer {
+  SCVProfileEvent  *events;
+  u64              count; // published with release
+  u64              open;    // recorded zones without end yet
+  u64              skipped; // dropped zones without end yet
+  u64              dropped;
+  u64              epoch;   // reset it saw last, published after count
+  u32              tid;
+  SCVProfileBuffer *next;
+};
+
+typedef struct SCVProfiler SCVProfiler;
+struct SCVProfiler {
+  SCVProfileBuffer *buffers;
+  u32              threads;
+  u32              arenaLock;
+  u64              epoch;   // bumped by scvProfileReset
+  u64              startTicks;
+  SCVArena         arena;
+};
+
+typedef struct SCVZoneStats SCVZoneStats;
+struct SCVZoneStats {
+  char *name;
+  u64  count;
+  u64  minNs;
+  u64  maxNs;
+  u64  meanNs;
+  u64  p99Ns;
+  u64  totalNs;
+};
+
+SCVProfiler scvProfiler = {0};
+scvThreadLocal SCVProfileBuffer *scvProfileThreadBuffer = nil;
+
+SCVProfileBuffer*
+scvProfileGetThreadBuffer(void)
+{
+  SCVProfileBuffer *buffer = scvProfileThreadBuffer;
+  SCVError error = {0};
+  u32 expected = 0;
+
+  if (buffer) {
+    return buffer;
+  }
+
+  while (!scvAtomicCAS(&scvProfiler.arenaLock, &expected, 1u)) {
+    expected = 0;
+  }
+  if (scvProfiler.arena.buf == nil) {
+    scvArenaInitReserve(&scvProfiler.arena, (u64)1 << 34, &error);
+    if (error.tag) {
+      scvFatalError("can't reserve profiler arena", &error);
+    }
+    scvProfiler.arena.tag = SCV_MEM_TAG_PROFILE;
+    scvProfiler.startTicks = scvCntVct();
+  }
+  buffer = scvArenaAllocAlign(&scvProfiler.arena, sizeof(SCVProfileBuffer), nil, scvCacheLineSize);
+  // pages of event array are committed but untouched until used
+  buffer->events = scvArenaAllocAlignNoZero(&scvProfiler.arena,
+      SCV_PROFILE_EVENTS * sizeof(SCVProfileEvent), nil, scvCacheLineSize);
+  buffer->tid = ++scvProfiler.threads;
+  buffer->epoch = scvAtomicLoad(&scvProfiler.epoch);
+  scvAtomicStore(&scvProfiler.arenaLock, 0u);
+  scvAssert(buffer->events);
+
+  buffer->next = scvAtomicLoadRelaxed(&scvProfiler.buffers);
+  while (!scvAtomicCAS(&scvProfiler.buffers, &buffer->next, buffer)) {}
+  scvProfileThreadBuffer = buffer;
+
+  return buffer;
+}
+
+void
+scvProfileBegin(char *name)
+{
+  SCVProfileBuffer *buffer = scvProfileGetThreadBuffer();
+  u64 count, epoch;
+
+  // reset is applied by owner between outermost zones
+  epoch = scvAtomicLoadRelaxed(&scvProfiler.epoch);
+  if (buffer->epoch != epoch && buffer->open == 0 && buffer->skipped == 0) {
+    scvAtomicStore(&buffer->count, 0);
+    buffer->dropped = 0;
+    scvAtomicStore(&buffer->epoch, epoch);
+  }
+  count = buffer->count;
+
+  // keep room for this zone end and ends of all open zones
+  if (buffer->skipped || count + buffer->open + 2 > SCV_PROFILE_EVENTS) {
+    buffer->skipped++;
+    buffer->dropped++;
+    return;
+  }
+
+  buffer->events[count].name = name;
+  buffer->events[count].ticks = scvCntVct();
+  buffer->open++;
+  scvAtomicStore(&buffer->count, count + 1);
+}
+
+void
+scvProfileEnd(void)
+{
+  u64 ticks = scvCntVct();
+  SCVProfileBuffer *buffer = scvProfileThreadBuffer;
+  u64 count;
+
+  if (!buffer) {
+    return;
+  }
+  if (buffer->skipped) {
+    buffer->skipped--;
+    return;
+  }
+  scvAssert(buffer->open > 0 && "scvZoneEnd without scvZoneBegin");
+
+  count = buffer->count;
+  buffer->events[count].name = nil;
+  buffer->events[count].ticks = ticks;
+  buffer->open--;
+  scvAtomicStore(&buffer->count, count + 1);
+}
+
+// drops recorded events of every thread, safe while other threads record.
+// Thread inside a zone keeps its events until that zone ends, they are
+// not read meanwhile.
+void
+scvProfileReset(void)
+{
+  scvProfiler.startTicks = scvCntVct();
+  scvAtomicAdd(&scvProfiler.epoch, 1);
+}
+
+// published events of buffer, 0 when owner didn't apply last reset yet
+u64
+scvProfileBufferCount(SCVProfileBuffer *buffer)
+{
+  if (scvAtomicLoad(&buffer->epoch) != scvAtomicLoad(&scvProfiler.epoch)) {
+    return 0;
+  }
+
+  return scvAtomicLoad(&buffer->count);
+}
+
+void
+scvWriterPutJSONString(SCVWriter *w, char *s)
+{
+  scvWriterPutByte(w, '"');
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\') {
+      scvWriterPutByte(w, '\\');
+    }
+    scvWriterPutByte(w, (u8)*s);
+  }
+  scvWriterPutByte(w, '"');
+}
+
+// chrome://tracing / perfetto "trace event" json, B/E pairs per thread
+void
+scvProfileWriteTrace(SCVWriter *w)
+{
+  SCVProfileBuffer *buffer = scvAtomicLoad(&scvProfiler.buffers);
+  f64 usPerTick = 1000000.0 / (f64)scvCntFrq();
+  SCVProfileEvent *e;
+  bool first = true;
+  u64 i, count;
+
+  scvWriterPutCString(w, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+  for (; buffer; buffer = buffer->next) {
+    count = scvProfileBufferCount(buffer);
+    for (i = 0; i < count; ++i) {
+      e = &buffer->events[i];
+      scvWriterPutCString(w, first ? "\n{\"ph\":\"" : ",\n{\"ph\":\"");
+      scvWriterPutCString(w, e->name ? "B\",\"name\":" : "E\"");
+      if (e->name) {
+        scvWriterPutJSONString(w, e->name);
+      }
+      scvWriterPutCString(w, ",\"pid\":1,\"tid\":");
+      scvWriterPutU64(w, buffer->tid);
+      scvWriterPutCString(w, ",\"ts\":");
+      scvWriterPutF64Fixed(w, (f64)(e->ticks - scvProfiler.startTicks) * usPerTick, 3);
+      scvWriterPutByte(w, '}');
+      first = false;
+    }
+  }
+  scvWriterPutCString(w, "\n]}\n");
+}
+
+bool
+scvProfileDumpTrace(char *path, SCVError *err)
+{
+  u8 buf[1 << 16];
+  SCVWriter w;
+  i32 fd;
+
+  fd = scvOpenat(AT_FDCWD, scvUnsafeCString(path), O_WRONLY | O_CREAT | O_TRUNC, 0644, err);
+  if (fd < 0) {
+    return false;
+  }
+  scvWriterFd(&w, fd, scvUnsafeSlice(buf, sizeof(buf)));
+  scvProfileWriteTrace(&w);
+  scvWriterFlush(&w);
+  scvClose(fd);
+  if (err && w.err.tag) {
+    *err = w.err;
+  }
+
+  return w.err.tag == 0;
+}
+
+// k-th smallest, reorders a
+u64
+scvSelectU64(u64 *a, u64 n, u64 k)
+{
+  u64 lo = 0, hi = n - 1, i, j, pivot, t;
+
+  while (lo < hi) {
+    pivot = a[lo + (hi - lo) / 2];
+    i = lo;
+    j = hi;
+    while (i <= j) {
+      while (a[i] < pivot) i++;
+      while (a[j] > pivot) j--;
+      if (i <= j) {
+        t = a[i]; a[i] = a[j]; a[j] = t;
+        i++;
+        if (j == 0) break;
+        j--;
+      }
+    }
+    if (k <= j) {
+      hi = j;
+    } else if (k >= i) {
+      lo = i;
+    } else {
+      break;
+    }
+  }
+
+  return a[k];
+}
+
+// per zone aggregates of everything recorded so far, zones in order of
+// first completion. Result lives in arena, intermediate arrays in scratch.
+// Zones still open are not counted
+SCVSlice
+scvProfileAggregate(SCVArena *arena)
+{
+  SCVArenaTemp scratch = scvScratchBegin(&arena, 1);
+  SCVProfileBuffer *buffer, *buffers = scvAtomicLoad(&scvProfiler.buffers);
+  SCVProfileEvent *e, *stack[SCV_PROFILE_MAX_DEPTH];
+  SCVSlice result;
+  SCVZoneStats *z;
+  SCVMap zones;
+  u64 *zoneOf, *duration, *sorted, *offsets, *index;
+  u64 i, count, depth, total = 0, done = 0, zoneCount = 0;
+  f64 nsPerTick = 1000000000.0 / (f64)scvCntFrq();
+
+  for (buffer = buffers; buffer; buffer = buffer->next) {
+    total += scvProfileBufferCount(buffer);
+  }
+  total = total / 2 + 1;
+
+  scvMapInit(&zones, scratch.arena, 64, false);
+  zoneOf = scvArenaAllocNoZero(scratch.arena, total * sizeof(u64));
+  duration = scvArenaAllocNoZero(scratch.arena, total * sizeof(u64));
+  scvAssert(zoneOf && duration);
+
+  // pair begin/end into (zone, duration)
+  for (buffer = buffers; buffer; buffer = buffer->next) {
+    count = scvProfileBufferCount(buffer);
+    depth = 0;
+    // owners keep recording, count may have grown since total
+    for (i = 0; i < count && done < total; ++i) {
+      e = &buffer->events[i];
+      if (e->name) {
+        if (depth < SCV_PROFILE_MAX_DEPTH) {
+          stack[depth] = e;
+        }
+        depth++;
+        continue;
+      }
+      if (depth == 0 || --depth >= SCV_PROFILE_MAX_DEPTH) {
+        continue;
+      }
+
+      index = scvMapGetU64(&zones, (u64)(uptr)stack[depth]->name);
+      if (!index) {
+        index = scvMapPutU64(&zones, (u64)(uptr)stack[depth]->name, zoneCount++);
+      }
+      zoneOf[done] = *index;
+      duration[done] = (u64)((f64)(e->ticks - stack[depth]->ticks) * nsPerTick);
+      done++;
+    }
+  }
+
+  result = scvMakeSlice(arena, SCVZoneStats, zoneCount, zoneCount);
+  z = result.base;
+  for (i = 0; i < zones.cap; ++i) {
+    if (!(zones.ctrl[i] & 0x80)) {
+      z[zones.entries[i].value].name = (char *)(uptr)zones.entries[i].key;
+      z[zones.entries[i].value].minNs = (u64)-1;
+    }
+  }
+  for (i = 0; i < done; ++i) {
+    SCVZoneStats *s = &z[zoneOf[i]];
+    s->count++;
+    s->totalNs += duration[i];
+    s->minNs = scvMin(s->minNs, duration[i]);
+    s->maxNs = scvMax(s->maxNs, duration[i]);
+  }
+
+  // group durations by zone for percentile selection
+  offsets = scvArenaAlloc(scratch.arena, (zoneCount + 1) * sizeof(u64));
+  sorted = scvArenaAllocNoZero(scratch.arena, (done + 1) * sizeof(u64));
+  scvAssert(offsets && sorted);
+  for (i = 0; i < zoneCount; ++i) {
+    offsets[i + 1] = offsets[i] + z[i].count;
+  }
+  for (i = 0; i < done; ++i) {
+    sorted[offsets[zoneOf[i]]++] = duration[i];
+  }
+  for (i = 0; i < zoneCount; ++i) {
+    u64 *d = sorted + offsets[i] - z[i].count;
+    z[i].meanNs = z[i].totalNs / z[i].count;
+    z[i].p99Ns = scvSelectU64(d, z[i].count, (z[i].count * 99 + 99) / 100 - 1);
+  }
+
+  scvScratchEnd(scratch);
+  return result;
+}
+
+void
+scvProfileWriteStats(SCVWriter *w, SCVSlice stats)
+{
+  SCVZoneStats *z = stats.base;
+  u64 i;
+
+  scvWriterPutCString(w, "zone                             count       min ns      mean ns       p99 ns       max ns\n");
+  for (i = 0; i < stats.len; ++i) {
+    u64 len = strlen(z[i].name);
+    scvWriterPutCString(w, z[i].name);
+    while (len++ < 28) {
+      scvWriterPutByte(w, ' ');
+    }
+    scvWriterPutU64Pad(w, z[i].count, 10, ' ');
+    scvWriterPutByte(w, ' ');
+    scvWriterPutU64Pad(w, z[i].minNs, 12, ' ');
+    scvWriterPutByte(w, ' ');
+    scvWriterPutU64Pad(w, z[i].meanNs, 12, ' ');
+    scvWriterPutByte(w, ' ');
+    scvWriterPutU64Pad(w, z[i].p99Ns, 12, ' ');
+    scvWriterPutByte(w, ' ');
+    scvWriterPutU64Pad(w, z[i].maxNs, 12, ' ');
+    scvWriterPutByte(w, '\n');
+  }
+}
+
+// jobs
+
+// only workers and thread which started pool can submit. Waiting runs other
+// jobs, so job can wait for jobs it spawned without deadlocking pool.
+
+#ifndef SCV_JOB_DEQUE_SIZE
+#define SCV_JOB_DEQUE_SIZE 4096
+#endif
+
+#ifndef SCV_JOB_MAX_WORKERS
+#define SCV_JOB_MAX_WORKERS 64
+#endif
+
+#define SCV_JOB_SPINS 256
+
+// plain jobs get [0, 1) range
+typedef void (*SCVJobProc)(void *data, u64 start, u64 end);
+
+typedef struct SCVJobCounter SCVJobCounter;
+struct SCVJobCounter {
+  u64 pending;
+};
+
+typedef struct SCVJob SCVJob;
+struct SCVJob {
+  SCVJobProc    proc;
+  void          *data;
+  u64           start;
+  u64           end;
+  SCVJobCounter *counter;
+};
+
+typedef struct SCVJobDeque SCVJobDeque;
+struct SCVJobDeque {
+  i64    top;
+  u8     pad0[scvCacheLineSize - sizeof(i64)];
+  i64    bottom;
+  u8     pad1[scvCacheLineSize - sizeof(i64)];
+  SCVJob jobs[SCV_JOB_DEQUE_SIZE];
+};
+
+typedef struct SCVJobWorker SCVJobWorker;
+struct SCVJobWorker {
+  SCVJobDeque deque;
+  SCVThread   thread;
+  u32         index;
+  u64         rng;
+};
+
+typedef struct SCVJobsDesc SCVJobsDesc;
+struct SCVJobsDesc {
+  u32 workers; // threads besides caller, 0 = one per cpu minus caller
+};
+
+typedef struct SCVJobs SCVJobs;
+struct SCVJobs {
+  SCVJobWorker    *workers;
+  u32             count; // including worker 0
+  u32             running;
+  u64             queued;   // submitted, not yet taken
+  u32             sleeping;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  SCVArena        arena;
+};
+
+SCVJobs scvJobs = {0};
+scvThreadLocal SCVJobWorker *scvJobsSelf = nil;
+
+bool
+scvJobDequePush(SCVJobDeque *d, SCVJob *job)
+{
+  i64 b = scvAtomicLoadRelaxed(&d->bottom);
+  i64 t = scvAtomicLoad(&d->top);
+  SCVJob *slot;
+
+  if (b - t >= SCV_JOB_DEQUE_SIZE) {
+    return false;
+  }
+  // thief with stale top may read slot concurrently, so no plain stores
+  slot = &d->jobs[b & (SCV_JOB_DEQUE_SIZE - 1)];
+  scvAtomicStoreRelaxed(&slot->proc, job->proc);
+  scvAtomicStoreRelaxed(&slot->data, job->data);
+  scvAtomicStoreRelaxed(&slot->start, job->start);
+  scvAtomicStoreRelaxed(&slot->end, job->end);
+  scvAtomicStoreRelaxed(&slot->counter, job->counter);
+  scvAtomicStore(&d->bottom, b + 1);
+
+  return true;
+}
+
+bool
+scvJobDequeTake(SCVJobDeque *d, SCVJob *out)
+{
+  i64 b = scvAtomicLoadRelaxed(&d->bottom) - 1;
+  i64 t;
+  bool ok = true;
+
+  scvAtomicStoreRelaxed(&d->bottom, b);
+  scvAtomicFence();
+  t = scvAtomicLoadRelaxed(&d->top);
+
+  if (t > b) {
+    scvAtomicStoreRelaxed(&d->bottom, b + 1);
+    return false;
+  }
+
+  *out = d->jobs[b & (SCV_JOB_DEQUE_SIZE - 1)];
+  if (t == b) {
+    // last job, race with thieves for it
+    ok = scvAtomicCASStrong(&d->top, &t, t + 1);
+    scvAtomicStoreRelaxed(&d->bottom, b + 1);
+  }
+
+  return ok;
+}
+
+bool
+scvJobDequeSteal(SCVJobDeque *d, SCVJob *out)
+{
+  i64 t = scvAtomicLoad(&d->top);
+  i64 b;
+  SCVJob *slot;
+
+  scvAtomicFence();
+  b = scvAtomicLoad(&d->bottom);
+  if (t >= b) {
+    return false;
+  }
+
+  // copy is only used when top wasn't moved by somebody else
+  slot = &d->jobs[t & (SCV_JOB_DEQUE_SIZE - 1)];
+  out->proc = scvAtomicLoadRelaxed(&slot->proc);
+  out->data = scvAtomicLoadRelaxed(&slot->data);
+  out->start = scvAtomicLoadRelaxed(&slot->start);
+  out->end = scvAtomicLoadRelaxed(&slot->end);
+  out->counter = scvAtomicLoadRelaxed(&slot->counter);
+
+  return scvAtomicCASStrong(&d->top, &t, t + 1);
+}
+
+void
+scvJobRun(SCVJob *job)
+{
+  job->proc(job->data, job->start, job->end);
+  if (job->counter) {
+    scvAtomicAdd(&job->counter->pending, (u64)-1);
+  }
+}
+
+// own deque first, then one pass over others starting from random one
+bool
+scvJobsRunOne(SCVJobWorker *self)
+{
+  SCVJob job;
+  u32 i, victim;
+
+  if (!scvJobDequeTake(&self->deque, &job)) {
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 7;
+    self->rng ^= self->rng << 17;
+    victim = (u32)(self->rng % scvJobs.count);
+    for (i = 0; i < scvJobs.count; ++i, victim = (victim + 1) % scvJobs.count) {
+      if (victim != self->index && scvJobDequeSteal(&scvJobs.workers[victim].deque, &job)) {
+        break;
+      }
+    }
+    if (i == scvJobs.count) {
+      return false;
+    }
+  }
+
+  scvAtomicAdd(&scvJobs.queued, (u64)-1);
+  scvJobRun(&job);
+
+  return true;
+}
+
+void*
+scvJobsThreadProc(void *arg)
+{
+  SCVJobWorker *self = arg;
+  u32 spins = 0;
+
+  scvJobsSelf = self;
+  while (scvAtomicLoad(&scvJobs.running)) {
+    if (scvJobsRunOne(self)) {
+      spins = 0;
+      continue;
+    }
+    if (++spins < SCV_JOB_SPINS) {
+      scvThreadYield();
+      continue;
+    }
+
+    // sleeping counter is raised before queued is checked, submitter does
+    // it the other way around, fences make sure one of them sees the other
+    pthread_mutex_lock(&scvJobs.mutex);
+    scvAtomicAdd(&scvJobs.sleeping, 1u);
+    scvAtomicFence();
+    while (scvAtomicLoad(&scvJobs.queued) == 0 && scvAtomicLoad(&scvJobs.running)) {
+      pthread_cond_wait(&scvJobs.cond, &scvJobs.mutex);
+    }
+    scvAtomicAdd(&scvJobs.sleeping, (u32)-1);
+    pthread_mutex_unlock(&scvJobs.mutex);
+    spins = 0;
+  }
+
+  return nil;
+}
+
+void
+scvJobsStart(SCVJobsDesc *desc)
+{
+  SCVError error = {0};
+  u32 i, workers = desc ? desc->workers : 0;
+
+  scvAssert(!scvJobs.running);
+  if (workers == 0) {
+    workers = scvCpuCount() - 1;
+  }
+  workers = scvMin(workers, SCV_JOB_MAX_WORKERS - 1);
+
+  if (scvJobs.arena.buf == nil) {
+    scvArenaInitReserve(&scvJobs.arena, (u64)1 << 30, &error);
+    if (error.tag) {
+      scvFatalError("can't reserve jobs arena", &error);
+    }
+  }
+  scvArenaReset(&scvJobs.arena);
+
+  scvJobs.count = workers + 1;
+  scvJobs.workers = scvArenaAllocAlign(&scvJobs.arena,
+      scvJobs.count * sizeof(SCVJobWorker), nil, scvCacheLineSize);
+  scvAssert(scvJobs.workers);
+  scvAtomicStore(&scvJobs.queued, 0);
+  pthread_mutex_init(&scvJobs.mutex, nil);
+  pthread_cond_init(&scvJobs.cond, nil);
+  scvAtomicStore(&scvJobs.running, 1u);
+
+  for (i = 0; i < scvJobs.count; ++i) {
+    scvJobs.workers[i].index = i;
+    scvJobs.workers[i].rng = 0x9e3779b97f4a7c15ull * (i + 1);
+  }
+  scvJobsSelf = &scvJobs.workers[0];
+
+  for (i = 1; i < scvJobs.count; ++i) {
+    if (!scvThreadCreate(&scvJobs.workers[i].thread, scvJobsThreadProc, &scvJobs.workers[i])) {
+      scvWarn("jobs", "can't start worker thread");
+      scvJobs.count = i;
+      break;
+    }
+  }
+}
+
+void
+scvJobsWake(void)
+{
+  scvAtomicFence();
+  if (scvAtomicLoad(&scvJobs.sleeping)) {
+    pthread_mutex_lock(&scvJobs.mutex);
+    pthread_cond_broadcast(&scvJobs.cond);
+    pthread_mutex_unlock(&scvJobs.mutex);
+  }
+}
+
+// pushes without waking anybody, counter must be raised already
+void
+scvJobsPush(SCVJob *job)
+{
+  SCVJobWorker *self = scvJobsSelf;
+
+  scvAssert(self && "submitting from thread outside of job system");
+  scvAtomicAdd(&scvJobs.queued, 1);
+  if (!scvJobDequePush(&self->deque, job)) {
+    scvAtomicAdd(&scvJobs.queued, (u64)-1);
+    scvJobRun(job);
+  }
+}
+
+void
+scvJobsRun(SCVJobProc proc, void *data, SCVJobCounter *counter)
+{
+  SCVJob job = { proc, data, 0, 1, counter };
 
-#define scvInfo(tag, msg) scvLog(tag, SCV_LOG_INFO, 0, msg, __LINE__, __FILE__)
+  if (counter) {
+    scvAtomicAdd(&counter->pending, 1);
+  }
+  scvJobsPush(&job);
+  scvJobsWake();
+}
 
-#define scvInfoID(tag, msg, id) scvLog(tag, SCV_LOG_INFO, id, msg, __LINE__, __FILE__)
+// proc gets [start, end) ranges of at most batch items
+void
+scvJobsParallelFor(SCVJobProc proc, void *data, u64 count, u64 batch, SCVJobCounter *counter)
+{
+  SCVJob job = { proc, data, 0, 0, counter };
+  u64 start;
 
+  scvAssert(batch > 0);
+  if (counter) {
+    scvAtomicAdd(&counter->pending, (count + batch - 1) / batch);
+  }
+  for (start = 0; start < count; start += batch) {
+    job.start = start;
+    job.end = scvMin(start + batch, count);
+    scvJobsPush(&job);
+  }
+  scvJobsWake();
+}
 
-// files
+// runs jobs until counter drops to zero
+void
+scvJobsWait(SCVJobCounter *counter)
+{
+  SCVJobWorker *self = scvJobsSelf;
 
-SCVSlice
-scvLoadFile(SCVString pathname, SCVError *error)
-{ 
-  i64 fd;
-  void *buf;
-  SCVSlice s = {0};
-  struct stat filestat = {0};
-  fd = scvOpen(pathname, 0, error);
-  if (fd < 0) {
-    return s;
-  } 
+  while (scvAtomicLoad(&counter->pending)) {
+    if (!self || !scvJobsRunOne(self)) {
+      scvThreadYield();
+    }
+  }
+}
+
+// waits for workers to exit, jobs left in deques are not run
+void
+scvJobsStop(void)
+{
+  u32 i;
+
+  if (!scvJobs.running) {
+    return;
+  }
+  scvAtomicStore(&scvJobs.running, 0u);
+  pthread_mutex_lock(&scvJobs.mutex);
+  pthread_cond_broadcast(&scvJobs.cond);
+  pthread_mutex_unlock(&scvJobs.mutex);
+  for (i = 1; i < scvJobs.count; ++i) {
+    scvThreadJoin(scvJobs.workers[i].thread);
+  }
+  pthread_mutex_destroy(&scvJobs.mutex);
+  pthread_cond_destroy(&scvJobs.cond);
+  scvJobsSelf = nil;
+}
+
+// async io
+
+// caller polls finished requests and never waits, file memory is taken from
+// request arena on the polling thread
+
+#ifndef SCV_IO_MAX_INFLIGHT
+#define SCV_IO_MAX_INFLIGHT 256
+#endif
+
+#ifndef SCV_IO_THREADS
+#define SCV_IO_THREADS 2
+#endif
+
+#define SCV_IO_READ_CHUNK (1ull << 30)
+
+enum SCVIOBackend {
+  SCV_IO_BACKEND_THREADS = 0,
+  SCV_IO_BACKEND_URING,
+};
+
+enum SCVIOStatus {
+  SCV_IO_IDLE = 0,
+  SCV_IO_OPENING,
+  SCV_IO_READING,
+  SCV_IO_DONE,
+  SCV_IO_FAILED,
+};
+
+enum SCVIOOpType {
+  SCV_IO_OP_OPEN = 1,
+  SCV_IO_OP_STAT,
+  SCV_IO_OP_READ,
+};
+
+// struct statx layout, only size is used
+typedef struct SCVStatx SCVStatx;
+struct SCVStatx {
+  u32 mask;
+  u32 blksize;
+  u64 attributes;
+  u32 nlink;
+  u32 uid;
+  u32 gid;
+  u16 mode;
+  u16 spare;
+  u64 ino;
+  u64 size;
+  u8  rest[256 - 48];
+};
+
+typedef struct SCVIORequest SCVIORequest;
+struct SCVIORequest {
+  SCVString    path; // zero terminated, alive until done
+  SCVArena     *arena;
+  void         *user;
+  u32          status;
+  SCVString    data; // contents in arena with trailing zero
+  SCVError     err;
+
+  i32          fd;
+  u32          waiting; // completions left in current stage
+  u64          size;
+  SCVIORequest *next;
+  SCVStatx     statx;
+};
+
+typedef struct SCVIOOp SCVIOOp;
+struct SCVIOOp {
+  SCVIORequest *req;
+  u32          type;
+  i64          res; // fd, bytes or -errno
+  u64          size;
+};
+
+typedef void (*SCVIONotifyProc)(void *data);
+
+typedef struct SCVIODesc SCVIODesc;
+struct SCVIODesc {
+  bool forceThreads;
+};
+
+typedef struct SCVIO SCVIO;
+struct SCVIO {
+  u32             backend;
+  u64             inflight;
+  SCVIORequest    *doneHead;
+  SCVIORequest    *doneTail;
+
+  // io_uring
+  i32             ringFd;
+  u8              *sqRing;
+  u8              *cqRing;
+  u64             sqRingSize;
+  u64             cqRingSize;
+  u32             *sqHead;
+  u32             *sqTail;
+  u32             sqMask;
+  u32             *sqArray;
+  void            *sqes;
+  u64             sqesSize;
+  u32             *cqHead;
+  u32             *cqTail;
+  u32             cqMask;
+  void            *cqes;
+  u32             toSubmit;
+
+  // threads, both queues under mutex
+  SCVThread       threads[SCV_IO_THREADS];
+  u32             threadCount;
+  u32             running;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  pthread_cond_t  doneCond;
+  SCVIOOp         queue[SCV_IO_MAX_INFLIGHT];
+  u32             queueHead;
+  u32             queueTail;
+  SCVIOOp         done[SCV_IO_MAX_INFLIGHT];
+  u32             doneHeadIndex;
+  u32             doneTailIndex;
+  SCVIONotifyProc notify; // called by io thread after every completion
+  void            *notifyData;
+};
+
+void scvIOComplete(SCVIO *io, SCVIORequest *req, u32 type, i64 res, u64 size);
+
+#if defined(__linux__)
+
+bool
+scvIOUringInit(SCVIO *io)
+{
+  struct io_uring_params params;
+  u64 probeBuf[(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op)) / 8];
+  struct io_uring_probe *probe = (struct io_uring_probe *)probeBuf;
+  u8 needed[] = { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ };
+  SCVSyscallResult r;
+  SCVError error = {0};
+  u32 i;
+
+  scvClear(&params, sizeof(params));
+  r = scvSyscall(SYS_io_uring_setup, 2 * SCV_IO_MAX_INFLIGHT, (uptr)&params, 0);
+  if (r.err) {
+    return false;
+  }
+  io->ringFd = (i32)r.r1;
+
+  scvClear(probeBuf, sizeof(probeBuf));
+  r = scvSyscall6(SYS_io_uring_register, (uptr)io->ringFd, IORING_REGISTER_PROBE, (uptr)probe, 256, 0, 0);
+  if (r.err || !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+    scvClose((u32)io->ringFd);
+    return false;
+  }
+  for (i = 0; i < sizeof(needed); ++i) {
+    if (needed[i] > probe->last_op || !(probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED)) {
+      scvClose((u32)io->ringFd);
+      return false;
+    }
+  }
+
+  io->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+  io->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  io->sqRingSize = scvMax(io->sqRingSize, io->cqRingSize);
+  io->sqRing = scvMmap(nil, io->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      io->ringFd, IORING_OFF_SQ_RING, &error);
+  io->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  io->sqes = scvMmap(nil, io->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+      io->ringFd, IORING_OFF_SQES, &error);
+  if (error.tag) {
+    if (io->sqRing) {
+      scvMunmap(io->sqRing, io->sqRingSize, nil);
+    }
+    scvClose((u32)io->ringFd);
+    return false;
+  }
+  io->cqRing = io->sqRing; // single mmap
+  io->cqRingSize = 0;
+
+  io->sqHead = (u32 *)(io->sqRing + params.sq_off.head);
+  io->sqTail = (u32 *)(io->sqRing + params.sq_off.tail);
+  io->sqMask = *(u32 *)(io->sqRing + params.sq_off.ring_mask);
+  io->sqArray = (u32 *)(io->sqRing + params.sq_off.array);
+  io->cqHead = (u32 *)(io->cqRing + params.cq_off.head);
+  io->cqTail = (u32 *)(io->cqRing + params.cq_off.tail);
+  io->cqMask = *(u32 *)(io->cqRing + params.cq_off.ring_mask);
+  io->cqes = io->cqRing + params.cq_off.cqes;
+
+  return true;
+}
+
+struct io_uring_sqe*
+scvIOUringSqe(SCVIO *io, SCVIORequest *req, u32 type)
+{
+  u32 tail = *io->sqTail + io->toSubmit;
+  struct io_uring_sqe *sqe = (struct io_uring_sqe *)io->sqes + (tail & io->sqMask);
+
+  // ring holds twice max inflight requests, each has at most two ops
+  scvAssert(tail - scvAtomicLoad(io->sqHead) <= io->sqMask);
+  scvClear(sqe, sizeof(*sqe));
+  sqe->user_data = (u64)(uptr)req | type;
+  io->sqArray[tail & io->sqMask] = tail & io->sqMask;
+  io->toSubmit++;
+
+  return sqe;
+}
+
+// submits everything queued in ring, false when ring can't take it now
+// (EAGAIN, EBUSY), ops stay queued until completions are reaped. On any
+// other error queued ops are failed with it.
+bool
+scvIOUringSubmit(SCVIO *io, u32 minComplete)
+{
+  u32 flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+  u32 head, tail, pending;
+  struct io_uring_sqe *sqe;
+  SCVSyscallResult r;
+
+  scvAtomicStore(io->sqTail, *io->sqTail + io->toSubmit);
+  io->toSubmit = 0;
+  tail = *io->sqTail;
+  pending = tail - scvAtomicLoad(io->sqHead);
+  if (!pending && !minComplete) {
+    return true;
+  }
+  do {
+    r = scvSyscall6(SYS_io_uring_enter, (uptr)io->ringFd, pending, minComplete, flags, 0, 0);
+  } while (r.err == EINTR);
+  if (r.err == EAGAIN || r.err == EBUSY) {
+    return false;
+  }
+  if (r.err == 0) {
+    return true;
+  }
 
-  scvFStat(fd, &filestat, error);
+  // kernel takes ops only inside enter, so what it didn't take can be dropped
+  head = scvAtomicLoad(io->sqHead);
+  scvAtomicStore(io->sqTail, head);
+  for (; head != tail; ++head) {
+    sqe = (struct io_uring_sqe *)io->sqes + io->sqArray[head & io->sqMask];
+    scvIOComplete(io, (SCVIORequest *)(uptr)(sqe->user_data & ~(u64)7),
+        (u32)(sqe->user_data & 7), -(i64)r.err, 0);
+  }
+
+  return true;
+}
 
-  if (filestat.st_size == 0) {
-    return s;
+// handles completions in ring, returns how many there were
+u32
+scvIOUringReap(SCVIO *io)
+{
+  struct io_uring_cqe *cqe;
+  u32 head, tail, n;
+  u64 data;
+  i32 res;
+
+  head = *io->cqHead;
+  tail = scvAtomicLoad(io->cqTail);
+  n = tail - head;
+  for (; head != tail; ++head) {
+    cqe = (struct io_uring_cqe *)io->cqes + (head & io->cqMask);
+    data = cqe->user_data;
+    res = cqe->res;
+    scvIOComplete(io, (SCVIORequest *)(uptr)(data & ~(u64)7), (u32)(data & 7), res, 0);
   }
+  // kernel may reuse entries once head passes them, so only after reading
+  scvAtomicStore(io->cqHead, tail);
+
+  return n;
+}
+
+#endif
+
+void*
+scvIOThreadProc(void *arg)
+{
+  SCVIO *io = arg;
+  SCVIOOp op;
+  SCVError err;
+  struct stat st;
+  i64 n;
+
+  pthread_mutex_lock(&io->mutex);
+  for (;;) {
+    while (io->queueHead == io->queueTail && io->running) {
+      pthread_cond_wait(&io->cond, &io->mutex);
+    }
+    if (!io->running) {
+      break;
+    }
+    op = io->queue[io->queueHead++ % SCV_IO_MAX_INFLIGHT];
+    pthread_mutex_unlock(&io->mutex);
+
+    scvClear(&err, sizeof(err));
+    if (op.type == SCV_IO_OP_OPEN) {
+      op.res = scvOpen(op.req->path, O_RDONLY, &err);
+      if (!err.tag) {
+        scvClear(&st, sizeof(st));
+        scvFStat((i32)op.res, &st, &err);
+        op.size = (u64)st.st_size;
+        if (err.tag) {
+          scvClose((u32)op.res);
+        }
+      }
+    } else {
+      // whole rest of file at once, short reads looped here
+      op.res = 0;
+      while (op.size < op.req->size) {
+        n = scvRead(op.req->fd, scvUnsafeSlice(op.req->data.base + op.size, op.req->size - op.size), &err);
+        if (err.tag || n <= 0) {
+          break;
+        }
+        op.size += (u64)n;
+      }
+      op.res = (i64)op.size;
+    }
+    if (err.tag) {
+      op.res = -(i64)err.tag;
+    }
 
-  buf = scvMmap(nil, filestat.st_size, PROT_READ | PROT_WRITE, MAP_FILE, fd, 0, error);
+    pthread_mutex_lock(&io->mutex);
+    io->done[io->doneTailIndex++ % SCV_IO_MAX_INFLIGHT] = op;
+    pthread_cond_signal(&io->doneCond);
+    if (io->notify) {
+      SCVIONotifyProc notify = io->notify;
+      void *data = io->notifyData;
 
-  if (buf == 0) {
-    return s;
+      pthread_mutex_unlock(&io->mutex);
+      notify(data);
+      pthread_mutex_lock(&io->mutex);
+    }
   }
+  pthread_mutex_unlock(&io->mutex);
 
-  return scvUnsafeSlice(buf, filestat.st_size);
+  return nil;
 }
 
 void
-scvUnloadFile(SCVSlice sl)
+scvIOThreadsPush(SCVIO *io, SCVIORequest *req, u32 type)
 {
-  scvSliceMunmap(sl);
+  SCVIOOp op = { req, type, 0, 0 };
+
+  pthread_mutex_lock(&io->mutex);
+  io->queue[io->queueTail++ % SCV_IO_MAX_INFLIGHT] = op;
+  pthread_cond_signal(&io->cond);
+  pthread_mutex_unlock(&io->mutex);
 }
 
-// pool allocator
+void
+scvIOInit(SCVIO *io, SCVIODesc *desc)
+{
+  u32 i;
 
-typedef struct SCVPoolFreeNode SCVPoolFreeNode;
-struct SCVPoolFreeNode {
-  SCVPoolFreeNode *next;
+  scvClear(io, sizeof(*io));
+  io->ringFd = -1;
+
+#if defined(__linux__)
+  if (!(desc && desc->forceThreads) && scvIOUringInit(io)) {
+    io->backend = SCV_IO_BACKEND_URING;
+    return;
+  }
+#else
+  (void)desc;
+#endif
+
+  io->backend = SCV_IO_BACKEND_THREADS;
+  pthread_mutex_init(&io->mutex, nil);
+  pthread_cond_init(&io->cond, nil);
+  pthread_cond_init(&io->doneCond, nil);
+  io->running = 1;
+  for (i = 0; i < SCV_IO_THREADS; ++i) {
+    if (!scvThreadCreate(&io->threads[i], scvIOThreadProc, io)) {
+      break;
+    }
+    io->threadCount++;
+  }
+  scvAssert(io->threadCount > 0);
+}
+
+// requests in flight are abandoned, their arenas keep whatever was read
+void
+scvIORelease(SCVIO *io)
+{
+  u32 i;
+
+  if (io->backend == SCV_IO_BACKEND_URING) {
+    scvMunmap(io->sqes, io->sqesSize, nil);
+    scvMunmap(io->sqRing, io->sqRingSize, nil);
+    scvClose((u32)io->ringFd);
+    return;
+  }
+
+  pthread_mutex_lock(&io->mutex);
+  io->running = 0;
+  pthread_cond_broadcast(&io->cond);
+  pthread_mutex_unlock(&io->mutex);
+  for (i = 0; i < io->threadCount; ++i) {
+    scvThreadJoin(io->threads[i]);
+  }
+  pthread_mutex_destroy(&io->mutex);
+  pthread_cond_destroy(&io->cond);
+  pthread_cond_destroy(&io->doneCond);
+}
+
+void
+scvIOIssue(SCVIO *io, SCVIORequest *req, u32 type)
+{
+#if defined(__linux__)
+  struct io_uring_sqe *sqe;
+
+  if (io->backend == SCV_IO_BACKEND_URING) {
+    sqe = scvIOUringSqe(io, req, type);
+    switch (type) {
+      case SCV_IO_OP_OPEN:
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (u64)(uptr)req->path.base;
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        break;
+      case SCV_IO_OP_STAT:
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (u64)(uptr)req->path.base;
+        sqe->len = 0x200; // STATX_SIZE
+        sqe->off = (u64)(uptr)&req->statx;
+        break;
+      default:
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = req->fd;
+        sqe->addr = (u64)(uptr)(req->data.base + req->data.len);
+        sqe->len = (u32)scvMin(req->size - req->data.len, SCV_IO_READ_CHUNK);
+        sqe->off = req->data.len;
+        break;
+    }
+    return;
+  }
+#endif
+
+  scvIOThreadsPush(io, req, type);
+}
+
+void
+scvIOFinish(SCVIO *io, SCVIORequest *req, u32 status)
+{
+  if (req->fd >= 0) {
+    scvClose((u32)req->fd);
+    req->fd = -1;
+  }
+  req->status = status;
+  req->next = nil;
+  if (io->doneTail) {
+    io->doneTail->next = req;
+  } else {
+    io->doneHead = req;
+  }
+  io->doneTail = req;
+  io->inflight--;
+}
+
+void
+scvIOComplete(SCVIO *io, SCVIORequest *req, u32 type, i64 res, u64 size)
+{
+  if (res < 0) {
+    if (!req->err.tag) {
+      scvErrorSet(&req->err, type == SCV_IO_OP_READ ? "async read failed with code"
+                                                    : "async open failed with code", (uptr)-res);
+    }
+    if (type == SCV_IO_OP_READ) {
+      // read stage has nothing else waiting
+      scvIOFinish(io, req, SCV_IO_FAILED);
+      return;
+    }
+  } else if (type == SCV_IO_OP_OPEN) {
+    req->fd = (i32)res;
+    if (io->backend == SCV_IO_BACKEND_THREADS) {
+      req->size = size;
+    }
+  } else if (type == SCV_IO_OP_STAT) {
+    req->size = req->statx.size;
+  } else {
+    // uring reads come in chunks, thread reads whole rest at once
+    req->data.len = io->backend == SCV_IO_BACKEND_URING ? req->data.len + (u64)res : (u64)res;
+    if (res == 0 || req->data.len >= req->size) {
+      req->data.len = scvMin(req->data.len, req->size);
+      req->data.base[req->data.len] = 0;
+      scvIOFinish(io, req, SCV_IO_DONE);
+    } else {
+      scvIOIssue(io, req, SCV_IO_OP_READ);
+    }
+    return;
+  }
+
+  if (--req->waiting > 0) {
+    return;
+  }
+  if (req->err.tag) {
+    scvIOFinish(io, req, SCV_IO_FAILED);
+    return;
+  }
+
+  // open stage done, size known
+  req->data.base = scvArenaAllocAlignNoZero(req->arena, req->size + 1, &req->err, SCV_DEFAULT_ALIGNMENT);
+  if (!req->data.base) {
+    scvIOFinish(io, req, SCV_IO_FAILED);
+    return;
+  }
+  req->data.len = 0;
+  req->data.base[0] = 0;
+  if (req->size == 0) {
+    scvIOFinish(io, req, SCV_IO_DONE);
+    return;
+  }
+  req->status = SCV_IO_READING;
+  scvIOIssue(io, req, SCV_IO_OP_READ);
+}
+
+// io_uring returns its ring fd to watch and never calls notify, thread
+// backend returns -1 and calls notify from io thread, proc must be thread safe
+i32
+scvIOSetNotify(SCVIO *io, SCVIONotifyProc notify, void *data)
+{
+  if (io->backend == SCV_IO_BACKEND_URING) {
+    return io->ringFd;
+  }
+
+  pthread_mutex_lock(&io->mutex);
+  io->notify = notify;
+  io->notifyData = data;
+  pthread_mutex_unlock(&io->mutex);
+
+  return -1;
+}
+
+// starts loading path into arena, request and path must stay alive until
+// request is returned by scvIOPoll or scvIOWait finishes
+void
+scvIOLoad(SCVIO *io, SCVIORequest *req, SCVString path, SCVArena *arena)
+{
+  scvAssert(path.base[path.len] == 0);
+  scvAssert(io->inflight < SCV_IO_MAX_INFLIGHT);
+
+  scvClear(req, sizeof(*req));
+  req->path = path;
+  req->arena = arena;
+  req->fd = -1;
+  req->status = SCV_IO_OPENING;
+  io->inflight++;
+
+  if (io->backend == SCV_IO_BACKEND_URING) {
+    req->waiting = 2;
+    scvIOIssue(io, req, SCV_IO_OP_OPEN);
+    scvIOIssue(io, req, SCV_IO_OP_STAT);
+  } else {
+    req->waiting = 1;
+    scvIOIssue(io, req, SCV_IO_OP_OPEN);
+  }
+}
+
+// starts everything queued by scvIOLoad since last submit/poll
+void
+scvIOSubmit(SCVIO *io)
+{
+#if defined(__linux__)
+  if (io->backend == SCV_IO_BACKEND_URING) {
+    // busy ring keeps ops queued, next poll submits them
+    scvIOUringSubmit(io, 0);
+  }
+#else
+  (void)io;
+#endif
+}
+
+// handles everything completed so far, minComplete > 0 blocks until that
+// many ops complete
+void
+scvIOReap(SCVIO *io, u32 minComplete)
+{
+  SCVIOOp op;
+
+#if defined(__linux__)
+  if (io->backend == SCV_IO_BACKEND_URING) {
+    // busy ring takes ops again once completions are reaped, anything
+    // reaped counts as waited for
+    while (!scvIOUringSubmit(io, minComplete)) {
+      if (scvIOUringReap(io)) {
+        minComplete = 0;
+      } else {
+        scvThreadYield();
+      }
+    }
+    scvIOUringReap(io);
+    // next stages of what just completed
+    while (!scvIOUringSubmit(io, 0)) {
+      if (!scvIOUringReap(io)) {
+        scvThreadYield();
+      }
+    }
+    return;
+  }
+#endif
+
+  pthread_mutex_lock(&io->mutex);
+  while (minComplete && io->doneHeadIndex == io->doneTailIndex) {
+    pthread_cond_wait(&io->doneCond, &io->mutex);
+  }
+  while (io->doneHeadIndex != io->doneTailIndex) {
+    op = io->done[io->doneHeadIndex++ % SCV_IO_MAX_INFLIGHT];
+    pthread_mutex_unlock(&io->mutex);
+    scvIOComplete(io, op.req, op.type, op.res, op.size);
+    pthread_mutex_lock(&io->mutex);
+  }
+  pthread_mutex_unlock(&io->mutex);
+}
+
+// never blocks, returns up to max finished (done or failed) requests
+u64
+scvIOPoll(SCVIO *io, SCVIORequest **out, u64 max)
+{
+  u64 n = 0;
+
+  scvIOReap(io, 0);
+  while (n < max && io->doneHead) {
+    out[n++] = io->doneHead;
+    io->doneHead = io->doneHead->next;
+  }
+  if (!io->doneHead) {
+    io->doneTail = nil;
+  }
+
+  return n;
+}
+
+// blocks until req finishes, it's not returned by scvIOPoll after that
+void
+scvIOWait(SCVIO *io, SCVIORequest *req)
+{
+  SCVIORequest *it, *prev = nil;
+
+  while (req->status != SCV_IO_DONE && req->status != SCV_IO_FAILED) {
+    scvIOReap(io, 1);
+  }
+
+  for (it = io->doneHead; it; prev = it, it = it->next) {
+    if (it != req) {
+      continue;
+    }
+    if (prev) {
+      prev->next = it->next;
+    } else {
+      io->doneHead = it->next;
+    }
+    if (io->doneTail == it) {
+      io->doneTail = prev;
+    }
+    break;
+  }
+}
+
+// event loop
+
+// sleeps in epoll_wait, invalidate wakes loop only when it was clean, so
+// invalidates between two frames turn into one wakeup
+
+#if defined(__linux__)
+
+#define SCV_LOOP_WAKE_ID  ((u64)-1)
+#define SCV_LOOP_TIMER_ID ((u64)-2)
+
+typedef struct SCVLoopEvent SCVLoopEvent;
+struct SCVLoopEvent {
+  u64 id;     // given to scvLoopAddFd, or SCV_LOOP_WAKE_ID/SCV_LOOP_TIMER_ID
+  u32 events; // EPOLLIN, EPOLLHUP...
 };
 
-typedef struct SCVPool SCVPool;
-struct SCVPool {
-  u8              *buf;
-  u64             len;
-  u64             chunkSize;
-  SCVPoolFreeNode *head;
+typedef struct SCVLoop SCVLoop;
+struct SCVLoop {
+  i32 epollFd;
+  i32 wakeFd;  // eventfd
+  i32 timerFd;
+  u32 dirty;
+  u64 wakeups; // returns from epoll_wait, for idle cost checks
 };
 
-void 
-scvPoolFreeAll(SCVPool *pool)
+bool
+scvLoopCtl(SCVLoop *loop, i32 op, i32 fd, u64 id, u32 events, SCVError *err)
 {
-  u64 chunkCount;
-  u64 i;
+  struct epoll_event ev;
+  SCVSyscallResult r;
+
+  scvClear(&ev, sizeof(ev));
+  ev.events = events;
+  ev.data.u64 = id;
+  r = scvSyscall6(SYS_epoll_ctl, (uptr)loop->epollFd, (uptr)op, (uptr)fd, (uptr)&ev, 0, 0);
+  if (r.err) {
+    scvErrorSet(err, "epoll_ctl failed with code", r.err);
+    return false;
+  }
+
+  return true;
+}
+
+void
+scvLoopRelease(SCVLoop *loop)
+{
+  if (loop->timerFd >= 0) {
+    scvClose((u32)loop->timerFd);
+  }
+  if (loop->wakeFd >= 0) {
+    scvClose((u32)loop->wakeFd);
+  }
+  if (loop->epollFd >= 0) {
+    scvClose((u32)loop->epollFd);
+  }
+  loop->epollFd = loop->wakeFd = loop->timerFd = -1;
+}
+
+// loop starts dirty, so the first frame is drawn without invalidate
+bool
+scvLoopInit(SCVLoop *loop, SCVError *err)
+{
+  SCVSyscallResult r;
+
+  scvClear(loop, sizeof(*loop));
+  loop->epollFd = loop->wakeFd = loop->timerFd = -1;
+  loop->dirty = 1;
+
+  r = scvSyscall(SYS_epoll_create1, O_CLOEXEC, 0, 0);
+  if (r.err) {
+    scvErrorSet(err, "epoll_create1 failed with code", r.err);
+    return false;
+  }
+  loop->epollFd = (i32)r.r1;
+
+  // eventfd and timerfd flags are the same bits as O_CLOEXEC/O_NONBLOCK
+  r = scvSyscall(SYS_eventfd2, 0, O_CLOEXEC | O_NONBLOCK, 0);
+  if (r.err) {
+    scvErrorSet(err, "eventfd2 failed with code", r.err);
+    scvLoopRelease(loop);
+    return false;
+  }
+  loop->wakeFd = (i32)r.r1;
+
+  r = scvSyscall(SYS_timerfd_create, CLOCK_MONOTONIC, O_CLOEXEC | O_NONBLOCK, 0);
+  if (r.err) {
+    scvErrorSet(err, "timerfd_create failed with code", r.err);
+    scvLoopRelease(loop);
+    return false;
+  }
+  loop->timerFd = (i32)r.r1;
+
+  if (!scvLoopCtl(loop, EPOLL_CTL_ADD, loop->wakeFd, SCV_LOOP_WAKE_ID, EPOLLIN, err) ||
+      !scvLoopCtl(loop, EPOLL_CTL_ADD, loop->timerFd, SCV_LOOP_TIMER_ID, EPOLLIN, err)) {
+    scvLoopRelease(loop);
+    return false;
+  }
 
-  chunkCount = pool->len / pool->chunkSize;
+  return true;
+}
 
-  for (i = 0; i < chunkCount; i++) {
-    void *ptr = &pool->buf[i * pool->chunkSize];
-    SCVPoolFreeNode *node = (SCVPoolFreeNode *)ptr;
-    node->next = pool->head;
-    pool->head = node;
-  }
+// level triggered, fd must be drained (or removed) before next wait
+bool
+scvLoopAddFd(SCVLoop *loop, i32 fd, u64 id, SCVError *err)
+{
+  return scvLoopCtl(loop, EPOLL_CTL_ADD, fd, id, EPOLLIN, err);
 }
 
-#define scvPoolInitDefault(p, m, size) scvPoolInit((p), (m), (size), SCV_DEFAULT_ALIGNMENT);
+bool
+scvLoopRemoveFd(SCVLoop *loop, i32 fd, SCVError *err)
+{
+  return scvLoopCtl(loop, EPOLL_CTL_DEL, fd, 0, 0, err);
+}
 
+// thread safe, makes current or next scvLoopWait return
 void
-scvPoolInit(SCVPool *pool, SCVSlice mem, u64 chunkSize, u64 chunkAlignment)
+scvLoopWake(SCVLoop *loop)
 {
-  scvAssert(pool);
-  scvAssert(mem.base != nil && mem.cap > 0);
-  uptr initialStart = (uptr)mem.base;
-  uptr start = scvAlignForward(initialStart, chunkAlignment);
-
-  u64 len = mem.cap - (u64)(start - initialStart);
-  chunkSize = (u64)scvAlignForward((uptr)chunkSize, chunkAlignment);
-
-  scvAssert(chunkSize >= sizeof(SCVPoolFreeNode));
-  scvAssert(len >= chunkSize);
-
-  pool->buf = (u8 *)mem.base;
-  pool->len = len;
-  pool->chunkSize = chunkSize;
-  pool->head = nil;
+  u64 one = 1;
 
-  scvPoolFreeAll(pool);
+  scvWrite(loop->wakeFd, &one, sizeof(one), nil);
 }
 
-void*
-scvPoolAlloc(SCVPool *pool)
+// thread safe, marks loop dirty and wakes it if it was clean
+void
+scvLoopInvalidate(SCVLoop *loop)
 {
-  scvAssert(pool);
-  SCVPoolFreeNode *node = pool->head;
-  if (node == nil) {
-    scvAssert(node);
-    return nil;
+  if (scvAtomicExchange(&loop->dirty, 1) == 0) {
+    scvLoopWake(loop);
   }
+}
 
-  pool->head = pool->head->next;
+// fits SCVIONotifyProc, data is loop
+void
+scvLoopInvalidateProc(void *data)
+{
+  scvLoopInvalidate(data);
+}
 
-  return memset(node, 0, pool->chunkSize);
+// true once after any number of invalidates
+bool
+scvLoopTakeDirty(SCVLoop *loop)
+{
+  return scvAtomicExchange(&loop->dirty, 0) != 0;
 }
 
+// one shot timer after ns, repeating every intervalNs when it's not 0,
+// ns == 0 disarms it. Ticks which were missed come as one event.
 void
-scvPoolFree(SCVPool *pool, void *ptr)
+scvLoopSetTimer(SCVLoop *loop, u64 ns, u64 intervalNs)
 {
-  SCVPoolFreeNode *node;
+  struct itimerspec spec;
 
-  void *start = pool->buf;
-  void *end   = &pool->buf[pool->len];
-  if (ptr == nil) {
-    return;
-  }
+  spec.it_value.tv_sec = (time_t)(ns / 1000000000ull);
+  spec.it_value.tv_nsec = (long)(ns % 1000000000ull);
+  spec.it_interval.tv_sec = (time_t)(intervalNs / 1000000000ull);
+  spec.it_interval.tv_nsec = (long)(intervalNs % 1000000000ull);
+  scvSyscall6(SYS_timerfd_settime, (uptr)loop->timerFd, 0, (uptr)&spec, 0, 0, 0);
+}
 
-  if (!(start <= ptr && ptr < end)) {
-    scvAssert(0);
-    return;
+// blocks until at least one event or timeoutMs passes (-1 waits forever,
+// 0 only checks), returns number of events put to out. Wake and timer fds
+// are drained here and show up with their ids.
+u64
+scvLoopWait(SCVLoop *loop, SCVLoopEvent *out, u64 max, i32 timeoutMs)
+{
+  struct epoll_event evs[32];
+  SCVSyscallResult r;
+  u64 i, n, drain;
+
+  max = scvMin(max, sizeof(evs) / sizeof(evs[0]));
+  do {
+    r = scvSyscall6(SYS_epoll_pwait, (uptr)loop->epollFd, (uptr)evs, max, (uptr)(i64)timeoutMs, 0, 0);
+  } while (r.err == EINTR);
+  scvAssert(r.err == 0);
+  loop->wakeups++;
+
+  n = r.r1;
+  for (i = 0; i < n; ++i) {
+    out[i].id = evs[i].data.u64;
+    out[i].events = evs[i].events;
+    if (out[i].id == SCV_LOOP_WAKE_ID) {
+      scvRead(loop->wakeFd, scvUnsafeSlice(&drain, sizeof(drain)), nil);
+    } else if (out[i].id == SCV_LOOP_TIMER_ID) {
+      scvRead(loop->timerFd, scvUnsafeSlice(&drain, sizeof(drain)), nil);
+    }
   }
 
-  node = (SCVPoolFreeNode *)ptr;
-  node->next = pool->head;
-  pool->head = node;
+  return n;
 }
 
+#endif
+
 // utf8
 
 typedef i32 rune;
@@ -943,4 +5264,483 @@ scvUTF8GetNext(SCVUTF8Iterator *iterator, SCVError *error)
 
 
 
+// bulk utf8
+
+// strict validation, invalid sequence becomes -1 rune and sets error
+
+#define SCV_UTF8_INVALID_RUNE -1
+
+#if defined(__AVX2__)
+#define SCV_UTF8_BLOCK 32
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+#define SCV_UTF8_BLOCK 16
+#else
+#define SCV_UTF8_BLOCK 8
+#endif
+
+// true when block of SCV_UTF8_BLOCK bytes is ascii, then widens it into out (if not nil)
+bool
+scvUTF8AsciiBlock(u8 *s, rune *out)
+{
+#if defined(__AVX2__)
+  __m256i v = _mm256_loadu_si256((__m256i *)s);
+  if (_mm256_movemask_epi8(v)) {
+    return false;
+  }
+  if (out) {
+    _mm256_storeu_si256((__m256i *)(out +  0), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)(s +  0))));
+    _mm256_storeu_si256((__m256i *)(out +  8), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)(s +  8))));
+    _mm256_storeu_si256((__m256i *)(out + 16), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)(s + 16))));
+    _mm256_storeu_si256((__m256i *)(out + 24), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)(s + 24))));
+  }
+  return true;
+#elif defined(__SSE2__)
+  __m128i zero = _mm_setzero_si128();
+  __m128i v = _mm_loadu_si128((__m128i *)s);
+  __m128i lo, hi;
+  if (_mm_movemask_epi8(v)) {
+    return false;
+  }
+  if (out) {
+    lo = _mm_unpacklo_epi8(v, zero);
+    hi = _mm_unpackhi_epi8(v, zero);
+    _mm_storeu_si128((__m128i *)(out +  0), _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128((__m128i *)(out +  4), _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128((__m128i *)(out +  8), _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128((__m128i *)(out + 12), _mm_unpackhi_epi16(hi, zero));
+  }
+  return true;
+#elif defined(__ARM_NEON)
+  uint8x16_t v = vld1q_u8(s);
+  uint16x8_t lo, hi;
+  if (vmaxvq_u8(v) >= 0x80) {
+    return false;
+  }
+  if (out) {
+    lo = vmovl_u8(vget_low_u8(v));
+    hi = vmovl_u8(vget_high_u8(v));
+    vst1q_s32(out +  0, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(lo))));
+    vst1q_s32(out +  4, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(lo))));
+    vst1q_s32(out +  8, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(hi))));
+    vst1q_s32(out + 12, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(hi))));
+  }
+  return true;
+#else
+  u64 v, i;
+  memcpy(&v, s, sizeof(v));
+  if (v & 0x8080808080808080ull) {
+    return false;
+  }
+  if (out) {
+    for (i = 0; i < 8; ++i) {
+      out[i] = (rune)s[i];
+    }
+  }
+  return true;
+#endif
+}
+
+// decodes one sequence at s[0..len), returns its length in bytes, *r is -1 if invalid
+u64
+scvUTF8DecodeOne(u8 *s, u64 len, rune *r)
+{
+  u8 b0 = s[0];
+  rune cp;
+
+  if (b0 < 0x80) {
+    *r = (rune)b0;
+    return 1;
+  }
+
+  if (b0 >= 0xc2 && b0 <= 0xdf) {
+    if (len >= 2 && (s[1] & 0xc0) == 0x80) {
+      *r = ((rune)(b0 & 0x1f) << 6) | (rune)(s[1] & 0x3f);
+      return 2;
+    }
+  } else if ((b0 & 0xf0) == 0xe0) {
+    if (len >= 3 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80) {
+      cp = ((rune)(b0 & 0x0f) << 12) | ((rune)(s[1] & 0x3f) << 6) | (rune)(s[2] & 0x3f);
+      if (cp >= 0x800 && !(cp >= 0xd800 && cp <= 0xdfff)) {
+        *r = cp;
+        return 3;
+      }
+    }
+  } else if (b0 >= 0xf0 && b0 <= 0xf4) {
+    if (len >= 4 && (s[1] & 0xc0) == 0x80 && (s[2] & 0xc0) == 0x80 && (s[3] & 0xc0) == 0x80) {
+      cp = ((rune)(b0 & 0x07) << 18) | ((rune)(s[1] & 0x3f) << 12) |
+           ((rune)(s[2] & 0x3f) << 6) | (rune)(s[3] & 0x3f);
+      if (cp >= 0x10000 && cp <= 0x10ffff) {
+        *r = cp;
+        return 4;
+      }
+    }
+  }
+
+  *r = SCV_UTF8_INVALID_RUNE;
+  return 1;
+}
+
+// out must have space for str.len runes (or be nil to only validate/count),
+// returns number of runes
+u64
+scvUTF8Decode(SCVString str, rune *out, SCVError *error)
+{
+  u8 *s = str.base;
+  u64 len = str.len;
+  u64 i = 0, n = 0, blockEnd;
+  rune r, dummy;
+  bool valid = true;
+
+  while (i < len) {
+    while (i + SCV_UTF8_BLOCK <= len && scvUTF8AsciiBlock(s + i, out ? out + n : nil)) {
+      i += SCV_UTF8_BLOCK;
+      n += SCV_UTF8_BLOCK;
+    }
+
+    // scalar until past the block that had non ascii byte in it
+    blockEnd = scvMin(i + SCV_UTF8_BLOCK, len);
+    while (i < blockEnd) {
+      i += scvUTF8DecodeOne(s + i, len - i, &r);
+      valid = valid && r != SCV_UTF8_INVALID_RUNE;
+      *(out ? out + n : &dummy) = r;
+      n++;
+    }
+  }
+
+  if (!valid) {
+    scvErrorSet(error, "UTF8 incorrect encoding pattern", (uptr)SCV_UTF8_INCORRECT_ENDCODING);
+  }
+
+  return n;
+}
+
+bool
+scvUTF8Validate(SCVString str)
+{
+  SCVError error = {0};
+
+  scvUTF8Decode(str, nil, &error);
+  return error.tag == 0;
+}
+
+// decodes into runes slice allocated from arena, slice len is rune count
+SCVSlice
+scvUTF8DecodeToSlice(SCVArena *arena, SCVString str, SCVError *error)
+{
+  SCVSlice runes = {0};
+
+  runes.base = scvArenaAllocAlignNoZero(arena, (str.len + 1) * sizeof(rune), error, SCV_DEFAULT_ALIGNMENT);
+  if (!runes.base) {
+    return runes;
+  }
+  runes.cap = str.len + 1;
+  runes.len = scvUTF8Decode(str, runes.base, error);
+
+  return runes;
+}
+
+// string search
+
+// offsets into searched string or -1, case insensitive variants fold ascii only
+
+#if defined(__AVX2__)
+#define SCV_SEARCH_BLOCK 32
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+#define SCV_SEARCH_BLOCK 16
+#else
+#define SCV_SEARCH_BLOCK 8
+#endif
+
+u8
+scvAsciiLower(u8 c)
+{
+  return (u8)(c - 'A') < 26 ? (u8)(c | 0x20) : c;
+}
+
+#if defined(__ARM_NEON)
+u32
+scvNeonMask(uint8x16_t eq)
+{
+  u8 weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+  uint8x16_t bits = vandq_u8(eq, vld1q_u8(weights));
+  uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+
+  sum = vpadd_u8(sum, sum);
+  sum = vpadd_u8(sum, sum);
+  return (u32)vget_lane_u8(sum, 0) | ((u32)vget_lane_u8(sum, 1) << 8);
+}
+#endif
+
+// mask of bytes equal to c in SCV_SEARCH_BLOCK bytes at p
+u32
+scvSearchMask(u8 *p, u8 c)
+{
+#if defined(__AVX2__)
+  __m256i v = _mm256_loadu_si256((__m256i *)p);
+  return (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)c)));
+#elif defined(__SSE2__)
+  __m128i v = _mm_loadu_si128((__m128i *)p);
+  return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)c)));
+#elif defined(__ARM_NEON)
+  return scvNeonMask(vceqq_u8(vld1q_u8(p), vdupq_n_u8(c)));
+#else
+  u32 i, mask = 0;
+  for (i = 0; i < SCV_SEARCH_BLOCK; ++i) {
+    mask |= (u32)(p[i] == c) << i;
+  }
+  return mask;
+#endif
+}
+
+// same, but block is folded to lower case first, c must be lower case
+u32
+scvSearchMaskFold(u8 *p, u8 c)
+{
+#if defined(__AVX2__)
+  __m256i v = _mm256_loadu_si256((__m256i *)p);
+  // 'A'..'Z' lands on -128..-103 as signed
+  __m256i t = _mm256_add_epi8(v, _mm256_set1_epi8(0x80 - 'A'));
+  __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), t);
+  v = _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+  return (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)c)));
+#elif defined(__SSE2__)
+  __m128i v = _mm_loadu_si128((__m128i *)p);
+  __m128i t = _mm_add_epi8(v, _mm_set1_epi8(0x80 - 'A'));
+  __m128i upper = _mm_cmplt_epi8(t, _mm_set1_epi8(-128 + 26));
+  v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+  return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)c)));
+#elif defined(__ARM_NEON)
+  uint8x16_t v = vld1q_u8(p);
+  uint8x16_t upper = vcleq_u8(vsubq_u8(v, vdupq_n_u8('A')), vdupq_n_u8(25));
+  v = vorrq_u8(v, vandq_u8(upper, vdupq_n_u8(0x20)));
+  return scvNeonMask(vceqq_u8(v, vdupq_n_u8(c)));
+#else
+  u32 i, mask = 0;
+  for (i = 0; i < SCV_SEARCH_BLOCK; ++i) {
+    mask |= (u32)(scvAsciiLower(p[i]) == c) << i;
+  }
+  return mask;
+#endif
+}
+
+bool
+scvMemEqualsFold(u8 *a, u8 *b, u64 len)
+{
+  u64 i;
+
+  for (i = 0; i < len; ++i) {
+    if (a[i] != b[i] && scvAsciiLower(a[i]) != scvAsciiLower(b[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool
+scvIsStringsEqualsFold(SCVString s1, SCVString s2)
+{
+  return s1.len == s2.len && scvMemEqualsFold(s1.base, s2.base, s1.len);
+}
+
+i64
+scvStringIndexByte(SCVString s, u8 c)
+{
+  u64 i = 0;
+  u32 mask;
+
+  for (; i + SCV_SEARCH_BLOCK <= s.len; i += SCV_SEARCH_BLOCK) {
+    mask = scvSearchMask(s.base + i, c);
+    if (mask) {
+      return (i64)(i + (u64)__builtin_ctz(mask));
+    }
+  }
+  for (; i < s.len; ++i) {
+    if (s.base[i] == c) {
+      return (i64)i;
+    }
+  }
+
+  return -1;
+}
+
+// backwards, lines are short so no simd here
+i64
+scvStringLastIndexByte(SCVString s, u8 c)
+{
+  u64 i;
+
+  for (i = s.len; i > 0; --i) {
+    if (s.base[i - 1] == c) {
+      return (i64)(i - 1);
+    }
+  }
+
+  return -1;
+}
+
+u64
+scvStringCountByte(SCVString s, u8 c)
+{
+  u64 i = 0, count = 0;
+
+  for (; i + SCV_SEARCH_BLOCK <= s.len; i += SCV_SEARCH_BLOCK) {
+    count += (u64)__builtin_popcount(scvSearchMask(s.base + i, c));
+  }
+  for (; i < s.len; ++i) {
+    count += s.base[i] == c;
+  }
+
+  return count;
+}
+
+i64
+scvStringIndexAnchored(SCVString s, SCVString needle, bool fold)
+{
+  u64 n = needle.len, i = 0;
+  u8 first, last;
+  u32 mask;
+
+  if (n == 0) {
+    return 0;
+  }
+  if (n > s.len) {
+    return -1;
+  }
+
+  first = fold ? scvAsciiLower(needle.base[0]) : needle.base[0];
+  last = fold ? scvAsciiLower(needle.base[n - 1]) : needle.base[n - 1];
+
+  for (; i + n - 1 + SCV_SEARCH_BLOCK <= s.len; i += SCV_SEARCH_BLOCK) {
+    if (fold) {
+      mask = scvSearchMaskFold(s.base + i, first) & scvSearchMaskFold(s.base + i + n - 1, last);
+    } else {
+      mask = scvSearchMask(s.base + i, first) & scvSearchMask(s.base + i + n - 1, last);
+    }
+    while (mask) {
+      u64 at = i + (u64)__builtin_ctz(mask);
+      if (fold ? scvMemEqualsFold(s.base + at + 1, needle.base + 1, n - 2 + (n == 1))
+               : memcmp(s.base + at + 1, needle.base + 1, n - 2 + (n == 1)) == 0) {
+        return (i64)at;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  for (; i + n <= s.len; ++i) {
+    if (fold ? scvMemEqualsFold(s.base + i, needle.base, n)
+             : memcmp(s.base + i, needle.base, n) == 0) {
+      return (i64)i;
+    }
+  }
+
+  return -1;
+}
+
+// offset of first occurrence of needle, 0 for empty needle
+i64
+scvStringIndex(SCVString s, SCVString needle)
+{
+  if (needle.len == 1) {
+    return scvStringIndexByte(s, needle.base[0]);
+  }
+  return scvStringIndexAnchored(s, needle, false);
+}
+
+// same, ascii letters compared case insensitive
+i64
+scvStringIndexFold(SCVString s, SCVString needle)
+{
+  return scvStringIndexAnchored(s, needle, true);
+}
+
+bool
+scvStringContains(SCVString s, SCVString needle)
+{
+  return scvStringIndex(s, needle) >= 0;
+}
+
+SCVString
+scvStringSub(SCVString s, u64 start, u64 end)
+{
+  scvAssert(start <= end && end <= s.len);
+  return scvUnsafeString(s.base + start, end - start);
+}
+
+// lines
+
+// lines exclude '\n' and trailing '\r', final '\n' gives no empty last line
+
+typedef struct SCVLineIterator SCVLineIterator;
+struct SCVLineIterator {
+  u64       index;
+  SCVString str;
+};
+
+SCVLineIterator
+scvLineIterator(SCVString str)
+{
+  SCVLineIterator iterator;
+  iterator.index = 0;
+  iterator.str   = str;
+
+  return iterator;
+}
+
+bool
+scvLineHasNext(SCVLineIterator *iterator)
+{
+  return iterator->index < iterator->str.len;
+}
+
+SCVString
+scvLineGetNext(SCVLineIterator *iterator)
+{
+  SCVString rest = scvStringSub(iterator->str, iterator->index, iterator->str.len);
+  i64 nl = scvStringIndexByte(rest, '\n');
+  u64 len = nl < 0 ? rest.len : (u64)nl;
+
+  iterator->index += nl < 0 ? len : len + 1;
+  if (len > 0 && rest.base[len - 1] == '\r') {
+    len--;
+  }
+
+  return scvUnsafeString(rest.base, len);
+}
+
+// returns number of matching lines, which can be bigger than cap of lines
+u64
+scvFilterLines(SCVString text, SCVString needle, bool ignoreCase, SCVSlice *lines)
+{
+  SCVString *out = lines->base;
+  SCVString rest, line;
+  u64 pos = 0, count = 0, start, end;
+  i64 at, nl;
+
+  lines->len = 0;
+  while (pos < text.len) {
+    rest = scvStringSub(text, pos, text.len);
+    at = ignoreCase ? scvStringIndexFold(rest, needle) : scvStringIndex(rest, needle);
+    if (at < 0) {
+      break;
+    }
+
+    start = pos + (u64)scvStringLastIndexByte(scvStringSub(rest, 0, (u64)at), '\n') + 1;
+    nl = scvStringIndexByte(scvStringSub(text, pos + (u64)at, text.len), '\n');
+    end = nl < 0 ? text.len : pos + (u64)at + (u64)nl;
+
+    line = scvStringSub(text, start, end);
+    if (line.len > 0 && line.base[line.len - 1] == '\r') {
+      line.len--;
+    }
+    if (lines->len < lines->cap) {
+      out[lines->len++] = line;
+    }
+    count++;
+    pos = end + 1;
+  }
+
+  return count;
+}
+
 #endif
@@ -7,6 +7,7 @@
  * scv.h
  * scv_linalg.h
  * scv_geom.h
+ * <stddef.h> - offsetof for vertex layout
  *
  * on apple particular:
  *  <OpenGL/gl3.h>
@@ -43,10 +44,9 @@ struct SCVTexture {
 };
 
 enum SCVVBOs {
-  SCV_VBO_POSITIONS = 0,
-  SCV_VBO_TEXCOORDS,
-  SCV_VBO_COLORS,
+  SCV_VBO_VERTICES = 0,
   SCV_VBO_INDICIES,
+  SCV_VBO_QUADS,
 
   SCV_VBO_LENGTH
 };
@@ -58,13 +58,66 @@ struct SCVVertex {
   SCVColor color;
 };
 
+// 16 bytes, uv as 16 bit normalized, color as 4 normalized bytes
+typedef struct SCVGLVertex SCVGLVertex;
+struct SCVGLVertex {
+  f32      position[2]; // shader vertexPosition
+  u16      texcoord[2]; // shader vertexTexCoord
+  SCVColor color;       // shader vertexColor
+};
+
+// one instance per rect, image or glyph, vertex shader expands it to quad.
+// Size and radius are quarter pixels.
+typedef struct SCVGLQuad SCVGLQuad;
+struct SCVGLQuad {
+  f32      position[2]; // top left, framebuffer pixels
+  u16      size[2];     // quarter pixels
+  u16      uv[4];       // top left and bottom right, 16 bit normalized
+  SCVColor color;
+  u16      radius;      // corner radius in quarter pixels, 0 is square
+  u16      flags;       // SCVGLQuadFlags
+};
+
+enum SCVGLQuadFlags {
+  SCV_QUAD_GLYPH = 1, // uv is in glyph texture
+};
+
+enum SCVGLQuadMode {
+  SCV_GL_QUAD_INSTANCED = 0,
+  SCV_GL_QUAD_VERTICES,     // 4 vertices + 6 indices per quad, old path
+};
+
+// layers are drawn in order. Inside of layer drawcall joins earlier one of
+// the same state only when it doesn't overlap anything drawn in between,
+// so painter's order holds without layers too
+enum SCVGLDrawSort {
+  SCV_GL_SORT_LAYERS = 0,
+  SCV_GL_SORT_NONE,       // submission order
+};
+
+#define SCV_GL_MAX_LAYER 0xffff
+
+enum SCVDrawKind {
+  SCV_DRAW_TRIANGLES = 0, // range of Indicies
+  SCV_DRAW_QUADS,         // range of Quads
+};
+
+enum SCVQuadAttribs {
+  SCV_QUAD_ATTRIB_POSITION = 0,
+  SCV_QUAD_ATTRIB_SIZE,
+  SCV_QUAD_ATTRIB_UV,
+  SCV_QUAD_ATTRIB_COLOR,
+  SCV_QUAD_ATTRIB_RADIUS,
+  SCV_QUAD_ATTRIB_FLAGS,
+
+  SCV_QUAD_ATTRIB_LENGTH
+};
+
 typedef struct SCVVertexes SCVVertexes;
 struct SCVVertexes {
-  f32 *positions; //  x, y, z (3) - component  per vertex; shader (location = 0) 
-  f32 *texcoords; //  u, v    (2) - components per vertex; shader (location = 1)
-  u8  *colors;    //  RGBA    (4) - components per vertex; shader (location = 2) 
-  u32 size;
-  u32 index;
+  SCVGLVertex *base;
+  u32         size;
+  u32         index;
 };
 
 typedef struct SCVDrawCall SCVDrawCall;
@@ -73,6 +126,10 @@ struct SCVDrawCall {
   u32 len;
   u32 texID;
   u32 shaderID;
+  u32 kind;       // SCVDrawKind
+  u32 layer;
+  u32 glyphTexID; // second texture of quads, 0 when not used yet
+  f32 bounds[4];  // min x, min y, max x, max y of what it draws
 };
 
 typedef struct SCVGlyph SCVGlyph;
@@ -85,24 +142,131 @@ struct SCVGlyph {
   i32   height;
   i32   xadvance;
   i32   lsb; // left side bearing
-  i32   tx; // offset inside texture x
-  i32   ty; // offset inside texture y
+  SCVHandle entry; // SCVAtlasEntry with bitmap, stale until drawn and after eviction
 };
 
 typedef struct SCVFont SCVFont;
 struct SCVFont {
-  SCVTexture *texture;  
-  SCVSlice   glyphs;
-  f32        size;
-  f32        scale;
-  i32        ascent;
-  i32        descent;
-  i32        linegap;
+  SCVArray       glyphs;     // SCVGlyph, added on first use
+  SCVMap         glyphIndex; // codepoint -> index in glyphs
+  stbtt_fontinfo info;
+  SCVMappedFile  file;       // font data, read again on every glyph miss
+  bool           mapped;     // file is mapping, else copy in arena
+  f32            size;
+  f32            scale;
+  i32            ascent;
+  i32            descent;
+  i32            linegap;
+};
+
+// per frame counters, reset by scvGLBegin
+typedef struct SCVGLStats SCVGLStats;
+struct SCVGLStats {
+  u64 flushes;
+  u64 drawcalls;
+  u64 binds;       // program and texture changes between draws
+  u64 merged;      // drawcalls folded into others of the same state
+  u64 uploads;     // buffer upload calls
+  u64 uploadBytes;
+  u64 atlasUploads; // atlas texture updates
+  u64 atlasBytes;
+  u64 glyphHits;      // glyphs drawn from atlas
+  u64 glyphMisses;    // glyphs rasterized
+  u64 glyphEvictions; // glyphs dropped with their page
+};
+
+// flushes append to ring and fence their draws, writer waits only when ring
+// wraps onto region still in flight. Subdata mode writes at offset 0, kept
+// to compare.
+
+enum SCVGLStreamMode {
+  SCV_GL_STREAM_MAP = 0,
+  SCV_GL_STREAM_ORPHAN,
+  SCV_GL_STREAM_SUBDATA,
+};
+
+#ifndef SCV_GL_STREAM_SIZE
+#define SCV_GL_STREAM_SIZE (4u << 20)
+#endif
+
+#define SCV_GL_STREAM_FENCES 64
+
+typedef struct SCVGLStream SCVGLStream;
+struct SCVGLStream {
+  u32    buffer;
+  u32    target;  // GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER
+  u32    mode;
+  u64    size;
+  u64    head;    // bytes ever written, ring offset is head % size
+  u64    retired; // GPU is done with everything written before it
+  u64    fenced;  // head at last fence
+  GLsync fences[SCV_GL_STREAM_FENCES];
+  u64    fenceEnds[SCV_GL_STREAM_FENCES];
+  u32    fenceHead;
+  u32    fenceTail;
+  u64    waits;   // fences which weren't signaled yet when needed
+};
+
+// when all pages are full least recently drawn page is dropped whole, its
+// entries go stale (lookup returns nil) and owners add them again. Pinned
+// entries keep their page. Plain rects sample white block at page start.
+// Glyph pages are R8 coverage swizzled to RRRR, read through second sampler.
+// Glyph pages are written on CPU copy, changed rect is uploaded once per flush.
+
+#define SCV_ATLAS_MAX_PAGES 16
+#define SCV_ATLAS_PADDING   1 // transparent texels around entry for linear filter
+#define SCV_ATLAS_WHITE     4
+
+typedef struct SCVAtlasShelf SCVAtlasShelf;
+struct SCVAtlasShelf {
+  u32 y;
+  u32 height;
+  u32 x;      // where next entry goes
+};
+
+enum SCVAtlasFlags {
+  SCV_ATLAS_PINNED = 1,
+  SCV_ATLAS_GLYPH  = 2, // grayscale coverage, goes to glyph page
+};
+
+typedef struct SCVAtlasPage SCVAtlasPage;
+struct SCVAtlasPage {
+  u32      glTexID;
+  bool     glyphs;   // R8 glyph page
+  u32      pinned;   // pinned entries, page is never dropped while > 0
+  u32      top;      // y where next shelf opens
+  u64      lastUsed; // frame page was drawn from or added to
+  SCVArray shelves;  // SCVAtlasShelf
+  SCVArray entries;  // SCVHandle, freed when page is dropped
+  u8       *shadow;  // glyph page texels, go to texture on flush
+  u32      dirty[4]; // x0, y0, x1, y1 of shadow not uploaded yet
+};
+
+typedef struct SCVAtlasEntry SCVAtlasEntry;
+struct SCVAtlasEntry {
+  u32 page;
+  u32 x;      // texels, padding excluded
+  u32 y;
+  u32 width;
+  u32 height;
+};
+
+typedef struct SCVAtlas SCVAtlas;
+struct SCVAtlas {
+  u32          size;     // page side in texels
+  u32          maxPages;
+  u32          pagesLen;
+  u64          frame;
+  SCVAtlasPage pages[SCV_ATLAS_MAX_PAGES];
+  SCVSlabPool  entries;  // SCVAtlasEntry
+  SCVArena     *arena;   // shelves and entry lists
+  u64          adds;
+  u64          evictions;
 };
 
 typedef struct SCVGLCtx SCVGLCtx;
 struct SCVGLCtx {
-  SCVSlice      Drawcalls;
+  SCVArray      Drawcalls; // SCVDrawCall
   u32           VAO;
   u32           DefaultTextureId;
   i32           PositionLocation;
@@ -112,11 +276,27 @@ struct SCVGLCtx {
   u32           DefaultShader;
   u32           VBO[SCV_VBO_LENGTH];
   SCVVertexes   Vertexes;
-  SCVSlice      Indicies;
+  SCVArray      Indicies;  // u32
+  SCVArray      Quads;     // SCVGLQuad
+  u32           Layer;     // of next drawcalls, see scvGLSetLayer
+  u32           DrawSort;  // SCVGLDrawSort
+  SCVArray      SortDrawcalls; // flush swaps sorted copies in
+  SCVArray      SortQuads;
+  SCVArray      SortIndicies;
+  u32           QuadMode;  // SCVGLQuadMode
+  u32           QuadVAO;
+  u32           QuadShader;
+  i32           QuadMVPLocation;
+  i32           QuadLocations[SCV_QUAD_ATTRIB_LENGTH];
+  SCVGLStream   VertexStream;
+  SCVGLStream   IndexStream;
+  SCVGLStream   QuadStream;
+  SCVAtlas      Atlas;
   SCVRect       Viewport;
-  SCVPool       Textures;
-  SCVPool       Fonts;
+  SCVSlabPool   Textures; // SCVTexture, can be used from loader threads
+  SCVSlabPool   Fonts;    // SCVFont
   f32           Scale;
+  SCVGLStats    Stats;
 };
 
 typedef struct SCVText SCVText;
@@ -133,6 +313,7 @@ struct SCVText {
 #define SCV_ERROR_SHADER_LINK 2
 
 void scvGLFlush(SCVGLCtx *ctx);
+void scvAtlasCommit(SCVGLCtx *ctx);
 u32 scvGLLoadTexture(SCVImage image);
 void scvGLPushIndex(SCVGLCtx *ctx, u32 indx);
 
@@ -183,7 +364,7 @@ scvGLLinkShaderProgram(u32 vertexShader, u32 fragmentShader, SCVError* err)
 
 char* scvDefaultVertexShader =
   "#version 330 core                                  \n"
-  "in vec3 vertexPosition;                            \n"
+  "in vec2 vertexPosition;                            \n"
   "in vec2 vertexTexCoord;                            \n"
   "in vec4 vertexColor;                               \n"
   "out vec2 fragTexCoord;                             \n"
@@ -193,7 +374,7 @@ char* scvDefaultVertexShader =
   "{                                                  \n"
   "   fragTexCoord  = vertexTexCoord;                 \n"
   "   fragColor     = vertexColor;                    \n"
-  "   gl_Position   = mvp*vec4(vertexPosition, 1.0);  \n" 
+  "   gl_Position   = mvp*vec4(vertexPosition, 1.0, 1.0); \n"
   "}                                                  \n";
 
 
@@ -209,43 +390,232 @@ char* scvDefaultFragmentShader =
   "   finalColor      = texelColor*fragColor;             \n"
   "}                                                      \n";
 
+// corner is (0,0) (1,0) (0,1) (1,1) for triangle strip
+char* scvQuadVertexShader =
+  "#version 330 core                                  \n"
+  "in vec2 quadPosition;                              \n"
+  "in vec2 quadSize;                                  \n"
+  "in vec4 quadUV;                                    \n"
+  "in vec4 quadColor;                                 \n"
+  "in float quadRadius;                               \n"
+  "in float quadFlags;                                \n"
+  "out vec2 fragTexCoord;                             \n"
+  "out vec4 fragColor;                                \n"
+  "out vec2 fragLocal;                                \n"
+  "flat out vec2 fragHalfSize;                        \n"
+  "flat out float fragRadius;                         \n"
+  "flat out float fragGlyph;                          \n"
+  "uniform mat4 mvp;                                  \n"
+  "void main()                                        \n"
+  "{                                                  \n"
+  "   vec2 corner   = vec2(gl_VertexID & 1, gl_VertexID >> 1); \n"
+  "   vec2 size     = quadSize*0.25;                  \n"
+  "   fragTexCoord  = mix(quadUV.xy, quadUV.zw, corner); \n"
+  "   fragColor     = quadColor;                      \n"
+  "   fragLocal     = (corner - 0.5)*size;            \n"
+  "   fragHalfSize  = size*0.5;                       \n"
+  "   fragRadius    = quadRadius*0.25;                \n"
+  "   fragGlyph     = mod(quadFlags, 2.0);            \n"
+  "   gl_Position   = mvp*vec4(quadPosition + corner*size, 1.0, 1.0); \n"
+  "}                                                  \n";
+
+// rounded corners from distance to rounded box, one pixel of antialiasing
+char* scvQuadFragmentShader =
+  "#version 330 core                                      \n"
+  "in vec2 fragTexCoord;                                  \n"
+  "in vec4 fragColor;                                     \n"
+  "in vec2 fragLocal;                                     \n"
+  "flat in vec2 fragHalfSize;                             \n"
+  "flat in float fragRadius;                              \n"
+  "flat in float fragGlyph;                               \n"
+  "out vec4 finalColor;                                   \n"
+  "uniform sampler2D texture0;                            \n"
+  "uniform sampler2D glyphs;                              \n"
+  "void main()                                            \n"
+  "{                                                      \n"
+  "   vec4 texelColor = mix(texture(texture0, fragTexCoord), \n"
+  "       texture(glyphs, fragTexCoord), fragGlyph);      \n"
+  "   finalColor      = texelColor*fragColor;             \n"
+  "   if (fragRadius > 0.0) {                             \n"
+  "     vec2 q = abs(fragLocal) - fragHalfSize + fragRadius; \n"
+  "     float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - fragRadius; \n"
+  "     finalColor.a *= clamp(0.5 - d, 0.0, 1.0);         \n"
+  "   }                                                   \n"
+  "}                                                      \n";
 
 u32
-scvGLBuildDefaultShaders(void)
+scvGLBuildShaders(char *vertexSrc, char *fragmentSrc)
 {
   u32 result;
   u32 vertexShader;
   u32 fragmentShader;
   SCVError error = {0};
   
-  vertexShader = scvGLCompileShader(scvUnsafeCString(scvDefaultVertexShader), GL_VERTEX_SHADER, &error);
+  vertexShader = scvGLCompileShader(scvUnsafeCString(vertexSrc), GL_VERTEX_SHADER, &error);
   if (error.tag) {
-    scvFatalError("Failed to compile default vertex shader", &error);
+    scvFatalError("Failed to compile vertex shader", &error);
   }
   
-  fragmentShader = scvGLCompileShader(scvUnsafeCString(scvDefaultFragmentShader), GL_FRAGMENT_SHADER, &error);
+  fragmentShader = scvGLCompileShader(scvUnsafeCString(fragmentSrc), GL_FRAGMENT_SHADER, &error);
   if (error.tag) {
-    scvFatalError("Failed to compile default vertex shader", &error);
+    scvFatalError("Failed to compile fragment shader", &error);
   }
 
   result = scvGLLinkShaderProgram(vertexShader, fragmentShader, &error);
   
   if (error.tag) {
-    scvFatalError("Failed to link default shader", &error);
+    scvFatalError("Failed to link shader", &error);
   }
 
   return result;  
 }
 
+u32
+scvGLBuildDefaultShaders(void)
+{
+  return scvGLBuildShaders(scvDefaultVertexShader, scvDefaultFragmentShader);
+}
+
+// streaming buffers
+
+void
+scvGLStreamInit(SCVGLStream *stream, u32 buffer, u32 target, u32 mode, u64 size)
+{
+  scvClear(stream, sizeof(*stream));
+  stream->buffer = buffer;
+  stream->target = target;
+  stream->mode = mode;
+  stream->size = size;
+  glBindBuffer(target, buffer);
+  glBufferData(target, size, nil, GL_STREAM_DRAW);
+}
+
+void
+scvGLStreamWaitOldest(SCVGLStream *stream)
+{
+  u32 i = stream->fenceHead % SCV_GL_STREAM_FENCES;
+  GLenum r;
+
+  r = glClientWaitSync(stream->fences[i], 0, 0);
+  if (r == GL_TIMEOUT_EXPIRED) {
+    stream->waits++;
+    do {
+      r = glClientWaitSync(stream->fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    } while (r == GL_TIMEOUT_EXPIRED);
+  }
+  scvAssert(r != GL_WAIT_FAILED);
+  glDeleteSync(stream->fences[i]);
+  stream->retired = stream->fenceEnds[i];
+  stream->fenceHead++;
+}
+
+// after draws which read everything written so far
+void
+scvGLStreamFence(SCVGLStream *stream)
+{
+  u32 i;
+
+  if (stream->mode != SCV_GL_STREAM_MAP || stream->fenced == stream->head) {
+    return;
+  }
+  if (stream->fenceTail - stream->fenceHead == SCV_GL_STREAM_FENCES) {
+    scvGLStreamWaitOldest(stream);
+  }
+  i = stream->fenceTail++ % SCV_GL_STREAM_FENCES;
+  stream->fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  stream->fenceEnds[i] = stream->head;
+  stream->fenced = stream->head;
+}
+
+// drops ring and fences, storage is respecified with at least size bytes
+void
+scvGLStreamReset(SCVGLStream *stream, u64 size)
+{
+  while (stream->fenceHead != stream->fenceTail) {
+    glDeleteSync(stream->fences[stream->fenceHead++ % SCV_GL_STREAM_FENCES]);
+  }
+  stream->size = scvMax(stream->size, size);
+  stream->head = stream->retired = stream->fenced = 0;
+  glBufferData(stream->target, stream->size, nil, GL_STREAM_DRAW);
+}
+
+// copies data to ring, returns its offset in buffer. Buffer is left bound
+// to stream target. align must divide stream size.
+u64
+scvGLStreamWrite(SCVGLStream *stream, void *data, u64 len, u64 align, SCVGLStats *stats)
+{
+  u64 pos, offset;
+  void *dst;
+
+  glBindBuffer(stream->target, stream->buffer);
+  if (len == 0) {
+    return 0;
+  }
+  if (len > stream->size) {
+    scvGLStreamReset(stream, scvMax(stream->size * 2, len));
+  }
+
+  if (stream->mode == SCV_GL_STREAM_SUBDATA) {
+    glBufferSubData(stream->target, 0, len, data);
+    stats->uploads++;
+    stats->uploadBytes += len;
+    return 0;
+  }
+
+  pos = (stream->head + align - 1) / align * align;
+  offset = pos % stream->size;
+  if (offset + len > stream->size) {
+    pos += stream->size - offset;
+    offset = 0;
+  }
+  if (offset == 0 && pos > 0 && stream->mode == SCV_GL_STREAM_ORPHAN) {
+    glBufferData(stream->target, stream->size, nil, GL_STREAM_DRAW);
+  }
+
+  if (stream->mode == SCV_GL_STREAM_MAP) {
+    // region is free when GPU is done with what was there one lap ago
+    while (pos + len > stream->retired + stream->size) {
+      if (stream->fenceHead == stream->fenceTail) {
+        scvGLStreamFence(stream);
+      }
+      if (stream->fenceHead == stream->fenceTail) {
+        // nothing in flight, whole ring is free however far write skipped to wrap
+        stream->retired = pos;
+        break;
+      }
+      scvGLStreamWaitOldest(stream);
+    }
+    dst = glMapBufferRange(stream->target, offset, len,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    scvAssert(dst);
+    memcpy(dst, data, len);
+    glUnmapBuffer(stream->target);
+  } else {
+    glBufferSubData(stream->target, offset, len, data);
+  }
+
+  stream->head = pos + len;
+  stats->uploads++;
+  stats->uploadBytes += len;
+
+  return offset;
+}
+
 typedef struct SCVGLCtxDesc SCVGLCtxDesc;
 struct SCVGLCtxDesc {
   SCVRect viewport;
   SCVArena *arena; 
   u32 vertexescount;
   u32 drawcalls;
-  u32 texturescount;
+  u32 texturescount; // initial capacity, pools grow when needed
   u32 fontscount;
   f32 scaleFactor;
+  u32 streammode;  // SCVGLStreamMode
+  u32 streamsize;  // bytes of each ring (vertices, indices and quads)
+  u32 quadmode;    // SCVGLQuadMode
+  u32 atlassize;   // atlas page side, clamped to GL_MAX_TEXTURE_SIZE
+  u32 atlaspages;  // pages before least recently used is dropped
+  u32 drawsort;    // SCVGLDrawSort
 };
 
 void
@@ -256,8 +626,12 @@ scvGLCtxDescDefault(SCVGLCtxDesc *desc) {
 
   desc->vertexescount = desc->vertexescount == 0 ? 1024 : desc->vertexescount;
   desc->drawcalls     = desc->drawcalls     == 0 ? 16   : desc->drawcalls;
-  desc->texturescount = desc->texturescount == 0 ? 256  : desc->texturescount;
-  desc->fontscount    = desc->fontscount    == 0 ? 128  : desc->fontscount;
+  desc->texturescount = desc->texturescount == 0 ? 64   : desc->texturescount;
+  desc->fontscount    = desc->fontscount    == 0 ? 8    : desc->fontscount;
+  desc->streamsize    = desc->streamsize    == 0 ? SCV_GL_STREAM_SIZE : desc->streamsize;
+  desc->atlassize     = desc->atlassize     == 0 ? 2048 : desc->atlassize;
+  desc->atlaspages    = desc->atlaspages    == 0 ? 4    : desc->atlaspages;
+  desc->atlaspages    = scvMin(desc->atlaspages, SCV_ATLAS_MAX_PAGES);
 }
 
 void
@@ -265,20 +639,18 @@ scvGLCtxInit(SCVGLCtx *ctx, SCVGLCtxDesc *desc)
 {
   SCVArena *arena;
   u32 indiceslen;
-  u32 texcoordslen;
-  u32 positionslen;
-  u32 colorslen;
-  SCVSlice texturesMem;
-  SCVSlice fontsMem;
+  u32 verticeslen;
+  u32 prevTag;
+  u32 i;
+  i32 maxTextureSize = 0;
+  SCVError error = {0};
   SCVImage defaultTextureImg = {0};
   u8 whitepixels[4] = { 255, 255, 255, 255 };
   scvGLCtxDescDefault(desc);
 
   arena = desc->arena;
   indiceslen    = sizeof(u32) * desc->vertexescount * 2;
-  texcoordslen  = sizeof(f32) * desc->vertexescount * 2;
-  positionslen  = sizeof(f32) * desc->vertexescount * 3;
-  colorslen     = sizeof(u8)  * desc->vertexescount * 4;
+  verticeslen   = sizeof(SCVGLVertex) * desc->vertexescount;
  
   desc->viewport.origin.x *= desc->scaleFactor;
   desc->viewport.origin.y *= desc->scaleFactor;
@@ -296,25 +668,36 @@ scvGLCtxInit(SCVGLCtx *ctx, SCVGLCtxDesc *desc)
   ctx->DefaultTextureId = scvGLLoadTexture(defaultTextureImg);
 
   glGenVertexArrays(1, &ctx->VAO); 
-  ctx->Drawcalls = scvMakeSlice(arena, SCVDrawCall, 0, desc->drawcalls);
-  scvAssert(ctx->Drawcalls.base);
+  prevTag = scvArenaSetTag(arena, SCV_MEM_TAG_DRAWCALLS);
+  ctx->Drawcalls = scvMakeArray(arena, SCVDrawCall, desc->drawcalls);
 
+  scvArenaSetTag(arena, SCV_MEM_TAG_VERTEXES);
   ctx->Vertexes.size      = desc->vertexescount;
-  ctx->Vertexes.texcoords = (f32 *)scvArenaAlloc(arena, (u64)texcoordslen);
-  scvAssert(ctx->Vertexes.texcoords);
-  ctx->Vertexes.positions = (f32 *)scvArenaAlloc(arena, (u64)positionslen);
-  scvAssert(ctx->Vertexes.positions);
-  ctx->Vertexes.colors    = (u8  *)scvArenaAlloc(arena, (u64)colorslen);
-  scvAssert(ctx->Vertexes.colors);
-  ctx->Indicies           = scvMakeSlice(arena, u32, 0, indiceslen);
-  scvAssert(ctx->Indicies.base);
-  texturesMem             = scvMakeSlice(arena, SCVTexture, 0, desc->texturescount);
-  scvPoolInitDefault(&ctx->Textures, texturesMem, sizeof(SCVTexture));
-  scvAssert(ctx->Textures.buf);
-
-  fontsMem = scvMakeSlice(arena, SCVFont, 0, desc->fontscount);
-  scvPoolInitDefault(&ctx->Fonts, fontsMem, sizeof(SCVFont));
-  scvAssert(ctx->Fonts.buf);
+  ctx->Vertexes.base      = (SCVGLVertex *)scvArenaAllocNoZero(arena, (u64)verticeslen);
+  scvAssert(ctx->Vertexes.base);
+
+  scvArenaSetTag(arena, SCV_MEM_TAG_INDICIES);
+  ctx->Indicies           = scvMakeArray(arena, u32, desc->vertexescount * 2);
+
+  scvArenaSetTag(arena, SCV_MEM_TAG_VERTEXES);
+  ctx->Quads              = scvMakeArray(arena, SCVGLQuad, desc->vertexescount);
+  ctx->QuadMode           = desc->quadmode;
+
+  ctx->DrawSort           = desc->drawsort;
+  ctx->SortQuads          = scvMakeArray(arena, SCVGLQuad, desc->vertexescount);
+  scvArenaSetTag(arena, SCV_MEM_TAG_INDICIES);
+  ctx->SortIndicies       = scvMakeArray(arena, u32, desc->vertexescount * 2);
+  scvArenaSetTag(arena, SCV_MEM_TAG_DRAWCALLS);
+  ctx->SortDrawcalls      = scvMakeArray(arena, SCVDrawCall, desc->drawcalls);
+
+  scvSlabPoolInitDefault(&ctx->Textures, sizeof(SCVTexture), desc->texturescount, &error);
+  scvAssert(error.tag == 0);
+  ctx->Textures.tag = SCV_MEM_TAG_TEXTURES;
+
+  scvSlabPoolInitDefault(&ctx->Fonts, sizeof(SCVFont), desc->fontscount, &error);
+  scvAssert(error.tag == 0);
+  ctx->Fonts.tag = SCV_MEM_TAG_FONTS;
+  scvArenaSetTag(arena, prevTag);
 
   glBindVertexArray(ctx->VAO);
   glGenBuffers(SCV_VBO_LENGTH, ctx->VBO);
@@ -333,82 +716,195 @@ scvGLCtxInit(SCVGLCtx *ctx, SCVGLCtxDesc *desc)
   ctx->MVPLocation = glGetUniformLocation(ctx->DefaultShader, "mvp");
   scvAssert(ctx->MVPLocation >= 0);
 
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->VBO[SCV_VBO_POSITIONS]);   
-  glBufferData(GL_ARRAY_BUFFER, positionslen, ctx->Vertexes.positions, GL_DYNAMIC_DRAW);
+  scvGLStreamInit(&ctx->VertexStream, ctx->VBO[SCV_VBO_VERTICES], GL_ARRAY_BUFFER,
+      desc->streammode, scvMax(desc->streamsize, verticeslen));
   glEnableVertexAttribArray(ctx->PositionLocation);
-  glVertexAttribPointer(ctx->PositionLocation, 3, GL_FLOAT, 0, 0, 0);
-
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->VBO[SCV_VBO_TEXCOORDS]);
-  glBufferData(GL_ARRAY_BUFFER, texcoordslen, ctx->Vertexes.texcoords, GL_DYNAMIC_DRAW);
+  glVertexAttribPointer(ctx->PositionLocation, 2, GL_FLOAT, GL_FALSE, sizeof(SCVGLVertex),
+      (void *)offsetof(SCVGLVertex, position));
   glEnableVertexAttribArray(ctx->TexcoordsLocation);
-  glVertexAttribPointer(ctx->TexcoordsLocation, 2, GL_FLOAT, 0, 0, 0);
-
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->VBO[SCV_VBO_COLORS]);
-  glBufferData(GL_ARRAY_BUFFER, colorslen, ctx->Vertexes.colors, GL_DYNAMIC_DRAW);
+  glVertexAttribPointer(ctx->TexcoordsLocation, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SCVGLVertex),
+      (void *)offsetof(SCVGLVertex, texcoord));
   glEnableVertexAttribArray(ctx->ColorLocation);
-  glVertexAttribPointer(ctx->ColorLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, 0);
+  glVertexAttribPointer(ctx->ColorLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SCVGLVertex),
+      (void *)offsetof(SCVGLVertex, color));
+
+  scvGLStreamInit(&ctx->IndexStream, ctx->VBO[SCV_VBO_INDICIES], GL_ELEMENT_ARRAY_BUFFER,
+      desc->streammode, scvMax(desc->streamsize, indiceslen));
+
+  // quads have own vertex array, pointers are set per draw since instance
+  // offset (base instance) is not in 3.3
+  ctx->QuadShader = scvGLBuildShaders(scvQuadVertexShader, scvQuadFragmentShader);
+  ctx->QuadMVPLocation = glGetUniformLocation(ctx->QuadShader, "mvp");
+  scvAssert(ctx->QuadMVPLocation >= 0);
+  ctx->QuadLocations[SCV_QUAD_ATTRIB_POSITION] = glGetAttribLocation(ctx->QuadShader, "quadPosition");
+  ctx->QuadLocations[SCV_QUAD_ATTRIB_SIZE]     = glGetAttribLocation(ctx->QuadShader, "quadSize");
+  ctx->QuadLocations[SCV_QUAD_ATTRIB_UV]       = glGetAttribLocation(ctx->QuadShader, "quadUV");
+  ctx->QuadLocations[SCV_QUAD_ATTRIB_COLOR]    = glGetAttribLocation(ctx->QuadShader, "quadColor");
+  ctx->QuadLocations[SCV_QUAD_ATTRIB_RADIUS]   = glGetAttribLocation(ctx->QuadShader, "quadRadius");
+  ctx->QuadLocations[SCV_QUAD_ATTRIB_FLAGS]    = glGetAttribLocation(ctx->QuadShader, "quadFlags");
+  glUseProgram(ctx->QuadShader);
+  glUniform1i(glGetUniformLocation(ctx->QuadShader, "texture0"), 0);
+  glUniform1i(glGetUniformLocation(ctx->QuadShader, "glyphs"), 1);
+  glUseProgram(0);
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx->VBO[SCV_VBO_INDICIES]);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indiceslen, ctx->Indicies.base, GL_DYNAMIC_DRAW);
+  glGenVertexArrays(1, &ctx->QuadVAO);
+  glBindVertexArray(ctx->QuadVAO);
+  scvGLStreamInit(&ctx->QuadStream, ctx->VBO[SCV_VBO_QUADS], GL_ARRAY_BUFFER,
+      desc->streammode, desc->streamsize);
+  for (i = 0; i < SCV_QUAD_ATTRIB_LENGTH; ++i) {
+    scvAssert(ctx->QuadLocations[i] >= 0);
+    glEnableVertexAttribArray(ctx->QuadLocations[i]);
+    glVertexAttribDivisor(ctx->QuadLocations[i], 1);
+  }
+  glBindVertexArray(0);
+
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  scvClear(&ctx->Atlas, sizeof(ctx->Atlas));
+  ctx->Atlas.size     = scvMin(desc->atlassize, (u32)maxTextureSize);
+  ctx->Atlas.maxPages = desc->atlaspages;
+  ctx->Atlas.arena    = arena;
+  scvSlabPoolInitDefault(&ctx->Atlas.entries, sizeof(SCVAtlasEntry), 256, &error);
+  scvAssert(error.tag == 0);
+  ctx->Atlas.entries.tag = SCV_MEM_TAG_TEXTURES;
+}
+
+void
+scvGLBoundsClear(SCVDrawCall *drawcall)
+{
+  drawcall->bounds[0] = drawcall->bounds[1] = 1e30f;
+  drawcall->bounds[2] = drawcall->bounds[3] = -1e30f;
+}
+
+void
+scvGLBoundsAdd(SCVDrawCall *drawcall, f32 x0, f32 y0, f32 x1, f32 y1)
+{
+  drawcall->bounds[0] = scvMin(drawcall->bounds[0], x0);
+  drawcall->bounds[1] = scvMin(drawcall->bounds[1], y0);
+  drawcall->bounds[2] = scvMax(drawcall->bounds[2], x1);
+  drawcall->bounds[3] = scvMax(drawcall->bounds[3], y1);
+}
+
+// touching edges don't count, they share no pixels
+bool
+scvGLBoundsOverlap(f32 *a, f32 *b)
+{
+  return a[0] < b[2] && b[0] < a[2] && a[1] < b[3] && b[1] < a[3];
 }
 
 void
 scvGLBegin(SCVGLCtx *ctx)
 {
+  ctx->Atlas.frame++;
   ctx->Vertexes.index = 0;
   ctx->Indicies.len   = 0;
+  ctx->Quads.len      = 0;
   ctx->Drawcalls.len  = 0;
-  scvSliceAppend(ctx->Drawcalls, ((SCVDrawCall){
+  ctx->Layer          = 0;
+  scvClear(&ctx->Stats, sizeof(ctx->Stats));
+  scvArrayPush(&ctx->Drawcalls, SCVDrawCall, ((SCVDrawCall){
       .start    = 0,
       .len      = 0,
       .texID    = ctx->DefaultTextureId,
       .shaderID = ctx->DefaultShader,
+      .kind     = SCV_DRAW_TRIANGLES,
   }));
+  scvGLBoundsClear(scvArrayLast(&ctx->Drawcalls, SCVDrawCall));
+}
+
+// drawcall which primitives of kind with textures go to, 0 texture keeps
+// the current one. Texture which isn't set yet in last drawcall is just
+// filled in, new drawcall starts only when state really differs (empty
+// last one is reused then).
+SCVDrawCall *
+scvGLUseDrawCall(SCVGLCtx *ctx, u32 kind, u32 texID, u32 glyphTexID)
+{
+  SCVDrawCall *drawcall = scvArrayLast(&ctx->Drawcalls, SCVDrawCall);
+
+  if (drawcall->kind == kind && drawcall->layer == ctx->Layer &&
+      (!texID || !drawcall->texID || drawcall->texID == texID) &&
+      (!glyphTexID || !drawcall->glyphTexID || drawcall->glyphTexID == glyphTexID)) {
+    drawcall->texID      = texID ? texID : drawcall->texID;
+    drawcall->glyphTexID = glyphTexID ? glyphTexID : drawcall->glyphTexID;
+    return drawcall;
+  }
+
+  texID      = texID ? texID : drawcall->texID;
+  glyphTexID = glyphTexID ? glyphTexID : drawcall->glyphTexID;
+  if (kind == SCV_DRAW_TRIANGLES) {
+    // triangles sample only first texture, and always do
+    texID      = texID ? texID : ctx->DefaultTextureId;
+    glyphTexID = 0;
+  }
+  if (drawcall->len != 0) {
+    drawcall = (SCVDrawCall *)scvArrayPushN(&ctx->Drawcalls, 1);
+  }
+  drawcall->start      = kind == SCV_DRAW_QUADS ? (u32)ctx->Quads.len : (u32)ctx->Indicies.len;
+  drawcall->len        = 0;
+  drawcall->texID      = texID;
+  drawcall->glyphTexID = glyphTexID;
+  drawcall->shaderID   = kind == SCV_DRAW_QUADS ? ctx->QuadShader : ctx->DefaultShader;
+  drawcall->kind       = kind;
+  drawcall->layer      = ctx->Layer;
+  scvGLBoundsClear(drawcall);
+
+  return drawcall;
+}
+
+// layer of everything drawn next, returns previous one
+u32
+scvGLSetLayer(SCVGLCtx *ctx, u32 layer)
+{
+  u32 prev = ctx->Layer;
+
+  scvAssert(layer <= SCV_GL_MAX_LAYER);
+  ctx->Layer = layer;
+
+  return prev;
+}
+
+// kind rects, images and glyphs are drawn with
+u32
+scvGLRectKind(SCVGLCtx *ctx)
+{
+  return ctx->QuadMode == SCV_GL_QUAD_INSTANCED ? SCV_DRAW_QUADS : SCV_DRAW_TRIANGLES;
 }
 
 void
 scvGLPushIndex(SCVGLCtx *ctx, u32 indx)
 {
-  u32 *indexes;
-  u64 len = ctx->Indicies.len;
-  SCVDrawCall *drawcall = &((SCVDrawCall *)ctx->Drawcalls.base)[ctx->Drawcalls.len - 1];
+  *(u32 *)scvArrayPushN(&ctx->Indicies, 1) = indx;
+  scvArrayLast(&ctx->Drawcalls, SCVDrawCall)->len++;
+}
 
-  scvAssert(len < ctx->Indicies.cap);
- 
-  indexes = (u32 *)ctx->Indicies.base;
-  indexes[len] = indx;
-  ctx->Indicies.len = len + 1;
-  drawcall->len++;
+// [0, 1] to 16 bit normalized
+u16
+scvGLPackUV(f32 uv)
+{
+  uv = uv < 0.0f ? 0.0f : (uv > 1.0f ? 1.0f : uv);
+
+  return (u16)(uv * 65535.0f + 0.5f);
 }
 
+// z of position is dropped, everything is drawn at the same depth
 u32
 scvGLPushVertex(SCVGLCtx *ctx, SCVVertex *vertex)
 {
-  f32 *positions;
-  f32 *texcoords;
-  u8  *colors;
+  SCVGLVertex *v;
   u64 index = ctx->Vertexes.index;
   f32 scale = ctx->Scale;
   
   scvAssert(index + 1 < ctx->Vertexes.size); 
 
-  positions = ctx->Vertexes.positions;
-
-  positions[index * 3 + 0] = vertex->position[0] * scale;
-  positions[index * 3 + 1] = vertex->position[1] * scale;
-  positions[index * 3 + 2] = vertex->position[2];
-
-  texcoords = ctx->Vertexes.texcoords;
-  texcoords[index * 2 + 0] = vertex->texcoord[0];
-  texcoords[index * 2 + 1] = vertex->texcoord[1];
-
-  colors = ctx->Vertexes.colors;
-  colors[index * 4 + 0] = vertex->color.r;
-  colors[index * 4 + 1] = vertex->color.g;
-  colors[index * 4 + 2] = vertex->color.b;
-  colors[index * 4 + 3] = vertex->color.a;
+  v = ctx->Vertexes.base + index;
+  v->position[0] = vertex->position[0] * scale;
+  v->position[1] = vertex->position[1] * scale;
+  v->texcoord[0] = scvGLPackUV(vertex->texcoord[0]);
+  v->texcoord[1] = scvGLPackUV(vertex->texcoord[1]);
+  v->color       = vertex->color;
 
   ctx->Vertexes.index  = index + 1;
+  scvGLBoundsAdd(scvArrayLast(&ctx->Drawcalls, SCVDrawCall),
+      vertex->position[0], vertex->position[1], vertex->position[0], vertex->position[1]);
 
   return index;
 }
@@ -421,14 +917,78 @@ struct SCVUVRect {
   SCVVec2 bottomright;
 };
 
+// center of white block of atlas page with texID, false for other textures
+bool
+scvAtlasWhiteUV(SCVAtlas *atlas, u32 texID, SCVUVRect *uv)
+{
+  u32 i;
+  f32 c;
+
+  for (i = 0; i < atlas->pagesLen; ++i) {
+    if (atlas->pages[i].glTexID == texID) {
+      c = (f32)(SCV_ATLAS_PADDING + SCV_ATLAS_WHITE / 2) / (f32)atlas->size;
+      uv->topleft[0]     = uv->topleft[1]     = c;
+      uv->topright[0]    = uv->topright[1]    = c;
+      uv->bottomleft[0]  = uv->bottomleft[1]  = c;
+      uv->bottomright[0] = uv->bottomright[1] = c;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+// quarter pixels, clamped to u16
+u16
+scvGLPackQuarter(f32 v)
+{
+  v = v * 4.0f + 0.5f;
+  v = v < 0.0f ? 0.0f : (v > 65535.0f ? 65535.0f : v);
 
+  return (u16)v;
+}
+
+void
+scvGLPushQuad(SCVGLCtx *ctx, SCVRect rect, SCVColor color, SCVUVRect *uvs, f32 radius, u32 flags)
+{
+  SCVGLQuad *quad;
+  SCVDrawCall *drawcall;
+  f32 scale = ctx->Scale;
+
+  drawcall = scvGLUseDrawCall(ctx, SCV_DRAW_QUADS, 0, 0);
+  drawcall->len++;
+  scvGLBoundsAdd(drawcall, rect.origin.x, rect.origin.y,
+      rect.origin.x + rect.size.width, rect.origin.y + rect.size.height);
+  quad = (SCVGLQuad *)scvArrayPushN(&ctx->Quads, 1);
+  quad->position[0] = rect.origin.x * scale;
+  quad->position[1] = rect.origin.y * scale;
+  quad->size[0]     = scvGLPackQuarter(rect.size.width * scale);
+  quad->size[1]     = scvGLPackQuarter(rect.size.height * scale);
+  quad->uv[0]       = uvs ? scvGLPackUV(uvs->topleft[0]) : 0;
+  quad->uv[1]       = uvs ? scvGLPackUV(uvs->topleft[1]) : 0;
+  quad->uv[2]       = uvs ? scvGLPackUV(uvs->bottomright[0]) : 65535;
+  quad->uv[3]       = uvs ? scvGLPackUV(uvs->bottomright[1]) : 65535;
+  quad->color       = color;
+  quad->radius      = scvGLPackQuarter(radius * scale);
+  quad->flags       = (u16)flags;
+}
+
+// flags (SCVGLQuadFlags) only matter for quads, vertices always sample
+// first texture
 void
-scvGLDrawRectInternal(SCVGLCtx *ctx, SCVRect rect, SCVColor color, SCVUVRect *uvs)
+scvGLDrawRectInternal(SCVGLCtx *ctx, SCVRect rect, SCVColor color, SCVUVRect *uvs, u32 flags)
 {
   u32 i1, i2, i3, i4;
   f32 x, y, width, height;
   SCVVertex vertex = {0};
 
+  if (ctx->QuadMode == SCV_GL_QUAD_INSTANCED) {
+    scvGLPushQuad(ctx, rect, color, uvs, 0.0f, flags);
+    return;
+  }
+
+  scvGLUseDrawCall(ctx, SCV_DRAW_TRIANGLES, 0, 0);
   if (ctx->Vertexes.index >= ctx->Vertexes.size - 5) {
     scvGLFlush(ctx);
   }
@@ -488,33 +1048,53 @@ scvGLDrawRectInternal(SCVGLCtx *ctx, SCVRect rect, SCVColor color, SCVUVRect *uv
 void
 scvGLDrawImage(SCVGLCtx *ctx, SCVRect rect, SCVColor color, u32 texID)
 {
-  SCVDrawCall drawcall = {0};
-  SCVDrawCall currentDrawCall = ((SCVDrawCall *)ctx->Drawcalls.base)[ctx->Drawcalls.len - 1];
-  if (currentDrawCall.texID != texID) {
-    drawcall.start = ctx->Indicies.len;
-    drawcall.len   = 0;
-    drawcall.shaderID = ctx->DefaultShader;
-    drawcall.texID = texID;
-    scvSliceAppend(ctx->Drawcalls, drawcall);
+  scvGLUseDrawCall(ctx, scvGLRectKind(ctx), texID, 0);
+  scvGLDrawRectInternal(ctx, rect, color, nil, 0);
+}
+
+// after atlas image or text rect stays in the same batch, drawn with
+// white block of current page (image or glyph one)
+SCVUVRect *
+scvGLUseWhite(SCVGLCtx *ctx, SCVUVRect *white, u32 *flags)
+{
+  SCVDrawCall *drawcall = scvArrayLast(&ctx->Drawcalls, SCVDrawCall);
+
+  *flags = 0;
+  if (scvAtlasWhiteUV(&ctx->Atlas, drawcall->texID, white)) {
+    return white;
   }
+  if (drawcall->kind == SCV_DRAW_QUADS && scvAtlasWhiteUV(&ctx->Atlas, drawcall->glyphTexID, white)) {
+    *flags = SCV_QUAD_GLYPH;
+    return white;
+  }
+  scvGLUseDrawCall(ctx, scvGLRectKind(ctx), ctx->DefaultTextureId, 0);
 
-  scvGLDrawRectInternal(ctx, rect, color, nil);
+  return nil;
 }
 
 void
 scvGLDrawRect(SCVGLCtx *ctx, SCVRect rect, SCVColor color)
 { 
-  SCVDrawCall drawcall = {0};
-  SCVDrawCall currentDrawCall = ((SCVDrawCall *)ctx->Drawcalls.base)[ctx->Drawcalls.len - 1];
-  if (currentDrawCall.texID != ctx->DefaultTextureId) {
-    drawcall.start = ctx->Indicies.len;
-    drawcall.len   = 0;
-    drawcall.shaderID = ctx->DefaultShader;
-    drawcall.texID = ctx->DefaultTextureId;
-    scvSliceAppend(ctx->Drawcalls, drawcall);
-  }
+  SCVUVRect white, *uvs;
+  u32 flags;
 
-  scvGLDrawRectInternal(ctx, rect, color, nil);
+  uvs = scvGLUseWhite(ctx, &white, &flags);
+  scvGLDrawRectInternal(ctx, rect, color, uvs, flags);
+}
+
+// vertex path has no rounded corners, draws it square
+void
+scvGLDrawRoundedRect(SCVGLCtx *ctx, SCVRect rect, SCVColor color, f32 radius)
+{
+  SCVUVRect white, *uvs;
+  u32 flags;
+
+  uvs = scvGLUseWhite(ctx, &white, &flags);
+  if (ctx->QuadMode == SCV_GL_QUAD_INSTANCED) {
+    scvGLPushQuad(ctx, rect, color, uvs, scvMin(radius, scvMin(rect.size.width, rect.size.height) * 0.5f), flags);
+  } else {
+    scvGLDrawRectInternal(ctx, rect, color, uvs, flags);
+  }
 }
 
 void
@@ -523,6 +1103,11 @@ scvGLDrawTriangle(SCVGLCtx *ctx, SCVVec2 p1, SCVVec2 p2, SCVVec2 p3, SCVColor co
   u32 indx;
   SCVVertex vertex = {0};
 
+  scvGLUseDrawCall(ctx, SCV_DRAW_TRIANGLES, 0, 0);
+  if (ctx->Vertexes.index >= ctx->Vertexes.size - 3) {
+    scvGLFlush(ctx);
+  }
+
   vertex.position[0] = p1[0];
   vertex.position[1] = p1[1];
   vertex.position[2] = 1.0f;
@@ -547,12 +1132,156 @@ scvGLDrawTriangle(SCVGLCtx *ctx, SCVVec2 p1, SCVVec2 p2, SCVVec2 p3, SCVColor co
   scvGLPushIndex(ctx, indx);
 }
 
+#ifndef SCV_GL_SORT_LOOKBACK
+#define SCV_GL_SORT_LOOKBACK 64
+#endif
+
+// run of drawcalls of one state, drawn together at the place it started
+typedef struct SCVGLSortBatch SCVGLSortBatch;
+struct SCVGLSortBatch {
+  u32 layer;
+  u32 kind;
+  u32 shaderID;
+  u32 texID;
+  u32 glyphTexID;
+  f32 bounds[4]; // union of its drawcalls
+};
+
+// key is layer | batch | submission index. Drawcall walks back over batches
+// of its layer (at most SCV_GL_SORT_LOOKBACK) and joins the first one of its
+// state, unless something it overlaps is in the way, then it opens new batch.
+// Neighbours of the same state merge into one drawcall, nothing is copied
+// when order doesn't change.
+void
+scvGLSortDrawCalls(SCVGLCtx *ctx)
+{
+  SCVArenaTemp scratch;
+  SCVArray t;
+  SCVDrawCall *drawcall, *merged = nil;
+  SCVGLSortBatch *batches, *batch;
+  u64 *keys, *tmp, n = 0, batchesLen = 0, i, j, seen, found, elsize;
+  SCVArray *src, *dst;
+  bool identity = true;
+
+  if (ctx->Drawcalls.len < 2) {
+    return;
+  }
+
+  scratch = scvScratchBegin(nil, 0);
+  keys    = scvArenaAllocNoZero(scratch.arena, ctx->Drawcalls.len * sizeof(u64));
+  tmp     = scvArenaAllocNoZero(scratch.arena, ctx->Drawcalls.len * sizeof(u64));
+  batches = scvArenaAllocNoZero(scratch.arena, ctx->Drawcalls.len * sizeof(SCVGLSortBatch));
+  scvAssert(keys && tmp && batches);
+  scvAssert(ctx->Drawcalls.len < (1u << 24));
+
+  for (i = 0; i < ctx->Drawcalls.len; ++i) {
+    drawcall = scvArrayGet(&ctx->Drawcalls, SCVDrawCall, i);
+    if (drawcall->len == 0) {
+      continue;
+    }
+
+    found = batchesLen;
+    for (j = batchesLen, seen = 0; j > 0 && seen < SCV_GL_SORT_LOOKBACK; --j) {
+      batch = &batches[j - 1];
+      if (batch->layer != drawcall->layer) {
+        continue;
+      }
+      seen++;
+      if (batch->kind == drawcall->kind && batch->shaderID == drawcall->shaderID &&
+          batch->texID == drawcall->texID && batch->glyphTexID == drawcall->glyphTexID) {
+        found = j - 1;
+        break;
+      }
+      if (scvGLBoundsOverlap(batch->bounds, drawcall->bounds)) {
+        break;
+      }
+    }
+
+    batch = &batches[found];
+    if (found == batchesLen) {
+      batchesLen++;
+      batch->layer      = drawcall->layer;
+      batch->kind       = drawcall->kind;
+      batch->shaderID   = drawcall->shaderID;
+      batch->texID      = drawcall->texID;
+      batch->glyphTexID = drawcall->glyphTexID;
+      memcpy(batch->bounds, drawcall->bounds, sizeof(batch->bounds));
+    } else {
+      batch->bounds[0] = scvMin(batch->bounds[0], drawcall->bounds[0]);
+      batch->bounds[1] = scvMin(batch->bounds[1], drawcall->bounds[1]);
+      batch->bounds[2] = scvMax(batch->bounds[2], drawcall->bounds[2]);
+      batch->bounds[3] = scvMax(batch->bounds[3], drawcall->bounds[3]);
+    }
+    keys[n++] = ((u64)drawcall->layer << 48) | (found << 24) | i;
+  }
+
+  scvRadixSortU64(keys, tmp, n);
+  for (i = 1; i < n && identity; ++i) {
+    identity = (keys[i - 1] & 0xffffff) < (keys[i] & 0xffffff);
+  }
+  if (identity) {
+    scvScratchEnd(scratch);
+    return;
+  }
+
+  scvArrayClear(&ctx->SortDrawcalls);
+  scvArrayClear(&ctx->SortQuads);
+  scvArrayClear(&ctx->SortIndicies);
+  for (i = 0; i < n; ++i) {
+    drawcall = scvArrayGet(&ctx->Drawcalls, SCVDrawCall, keys[i] & 0xffffff);
+    src = drawcall->kind == SCV_DRAW_QUADS ? &ctx->Quads : &ctx->Indicies;
+    dst = drawcall->kind == SCV_DRAW_QUADS ? &ctx->SortQuads : &ctx->SortIndicies;
+    elsize = src->size;
+
+    if (merged && merged->kind == drawcall->kind && merged->shaderID == drawcall->shaderID &&
+        merged->texID == drawcall->texID && merged->glyphTexID == drawcall->glyphTexID) {
+      merged->len += drawcall->len;
+      scvGLBoundsAdd(merged, drawcall->bounds[0], drawcall->bounds[1], drawcall->bounds[2], drawcall->bounds[3]);
+      ctx->Stats.merged++;
+    } else {
+      merged = (SCVDrawCall *)scvArrayPushN(&ctx->SortDrawcalls, 1);
+      *merged = *drawcall;
+      merged->start = (u32)dst->len;
+    }
+    scvArrayAppend(dst, (u8 *)src->base + drawcall->start * elsize, drawcall->len);
+  }
+
+  t = ctx->Drawcalls; ctx->Drawcalls = ctx->SortDrawcalls; ctx->SortDrawcalls = t;
+  t = ctx->Quads;     ctx->Quads     = ctx->SortQuads;     ctx->SortQuads     = t;
+  t = ctx->Indicies;  ctx->Indicies  = ctx->SortIndicies;  ctx->SortIndicies  = t;
+  scvScratchEnd(scratch);
+}
+
+// points quad attributes at instances from offset in quad buffer
+void
+scvGLQuadPointers(SCVGLCtx *ctx, u64 offset)
+{
+  i32 *loc = ctx->QuadLocations;
+
+  glBindBuffer(GL_ARRAY_BUFFER, ctx->QuadStream.buffer);
+  glVertexAttribPointer(loc[SCV_QUAD_ATTRIB_POSITION], 2, GL_FLOAT, GL_FALSE, sizeof(SCVGLQuad),
+      (void *)(uptr)(offset + offsetof(SCVGLQuad, position)));
+  glVertexAttribPointer(loc[SCV_QUAD_ATTRIB_SIZE], 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(SCVGLQuad),
+      (void *)(uptr)(offset + offsetof(SCVGLQuad, size)));
+  glVertexAttribPointer(loc[SCV_QUAD_ATTRIB_UV], 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SCVGLQuad),
+      (void *)(uptr)(offset + offsetof(SCVGLQuad, uv)));
+  glVertexAttribPointer(loc[SCV_QUAD_ATTRIB_COLOR], 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SCVGLQuad),
+      (void *)(uptr)(offset + offsetof(SCVGLQuad, color)));
+  glVertexAttribPointer(loc[SCV_QUAD_ATTRIB_RADIUS], 1, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(SCVGLQuad),
+      (void *)(uptr)(offset + offsetof(SCVGLQuad, radius)));
+  glVertexAttribPointer(loc[SCV_QUAD_ATTRIB_FLAGS], 1, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(SCVGLQuad),
+      (void *)(uptr)(offset + offsetof(SCVGLQuad, flags)));
+}
+
 void
 scvGLFlush(SCVGLCtx *ctx)
 {
   u32 i;
-  u32* indicies;
+  u32 program, texture, glyphTexture, kind;
+  i32 baseVertex;
+  u64 offset, quadOffset;
   SCVDrawCall *drawcall;
+  SCVDrawCall last = *scvArrayLast(&ctx->Drawcalls, SCVDrawCall);
   SCVPoint origin = ctx->Viewport.origin;
   SCVSize  size   = ctx->Viewport.size;
  
@@ -567,6 +1296,12 @@ scvGLFlush(SCVGLCtx *ctx)
    -1.0f, 1.0f, 0.0f, 1.0f
   };
 
+  scvZoneBegin("scvGLFlush");
+  if (ctx->DrawSort == SCV_GL_SORT_LAYERS) {
+    scvGLSortDrawCalls(ctx);
+  }
+  // glyphs rasterized since previous flush
+  scvAtlasCommit(ctx);
   glViewport((u32)origin.x, (u32)origin.y, (u32)size.width, (u32)size.height);
   glEnable(GL_BLEND); 
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -575,35 +1310,84 @@ scvGLFlush(SCVGLCtx *ctx)
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, ctx->DefaultTextureId);
 
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->VBO[SCV_VBO_POSITIONS]);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, ctx->Vertexes.index * 3 * sizeof(f32), ctx->Vertexes.positions);
+  // element buffer binding is part of VAO
+  glBindVertexArray(ctx->VAO);
+  // vertex offset is multiple of vertex size, draws start from it with base vertex
+  baseVertex = (i32)(scvGLStreamWrite(&ctx->VertexStream, ctx->Vertexes.base,
+        ctx->Vertexes.index * sizeof(SCVGLVertex), sizeof(SCVGLVertex), &ctx->Stats) / sizeof(SCVGLVertex));
+  ctx->Stats.flushes++;
 
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->VBO[SCV_VBO_TEXCOORDS]);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, ctx->Vertexes.index * 2 * sizeof(f32), ctx->Vertexes.texcoords);
+  // all drawcalls index into one upload, each draws from its own range
+  offset = scvGLStreamWrite(&ctx->IndexStream, ctx->Indicies.base,
+      ctx->Indicies.len * sizeof(u32), sizeof(u32), &ctx->Stats);
 
-  glBindBuffer(GL_ARRAY_BUFFER, ctx->VBO[SCV_VBO_COLORS]);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, ctx->Vertexes.index * 4 * sizeof(u8), ctx->Vertexes.colors);
+  quadOffset = scvGLStreamWrite(&ctx->QuadStream, ctx->Quads.base,
+      ctx->Quads.len * sizeof(SCVGLQuad), sizeof(f32), &ctx->Stats);
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ctx->VBO[SCV_VBO_INDICIES]);
-  glBindVertexArray(ctx->VAO);
+  glUseProgram(ctx->QuadShader);
+  glUniformMatrix4fv(ctx->QuadMVPLocation, 1, false, Proj);
+  glUseProgram(ctx->DefaultShader);
   glUniformMatrix4fv(ctx->MVPLocation, 1, false, Proj);
 
+  program      = ctx->DefaultShader;
+  texture      = ctx->DefaultTextureId;
+  glyphTexture = 0;
+  kind         = SCV_DRAW_TRIANGLES;
   for (i = 0; i < ctx->Drawcalls.len; ++i) {
-    drawcall = scvSliceGet(ctx->Drawcalls, SCVDrawCall, i);
-    indicies = scvSliceGet(ctx->Indicies, u32, drawcall->start);
-    glUseProgram(drawcall->shaderID);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, drawcall->texID);
-
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, drawcall->len * sizeof(u32), indicies);
-    glDrawElements(GL_TRIANGLES, drawcall->len, GL_UNSIGNED_INT, (void *)0); 
+    drawcall = scvArrayGet(&ctx->Drawcalls, SCVDrawCall, i);
+    if (drawcall->len == 0) {
+      continue;
+    }
+    if (drawcall->kind != kind) {
+      kind = drawcall->kind;
+      glBindVertexArray(kind == SCV_DRAW_QUADS ? ctx->QuadVAO : ctx->VAO);
+    }
+    // rebinding current shader or texture costs driver validation for nothing
+    if (drawcall->shaderID != program) {
+      program = drawcall->shaderID;
+      glUseProgram(program);
+      ctx->Stats.binds++;
+    }
+    if (drawcall->texID && drawcall->texID != texture) {
+      texture = drawcall->texID;
+      glBindTexture(GL_TEXTURE_2D, texture);
+      ctx->Stats.binds++;
+    }
+    if (kind == SCV_DRAW_QUADS && drawcall->glyphTexID && drawcall->glyphTexID != glyphTexture) {
+      glyphTexture = drawcall->glyphTexID;
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, glyphTexture);
+      glActiveTexture(GL_TEXTURE0);
+      ctx->Stats.binds++;
+    }
+    if (kind == SCV_DRAW_QUADS) {
+      scvGLQuadPointers(ctx, quadOffset + drawcall->start * sizeof(SCVGLQuad));
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, drawcall->len);
+    } else {
+      glDrawElementsBaseVertex(GL_TRIANGLES, drawcall->len, GL_UNSIGNED_INT,
+          (void *)(uptr)(offset + drawcall->start * sizeof(u32)), baseVertex);
+    }
+    ctx->Stats.drawcalls++;
   }
 
   
   glUseProgram(0);
-
+  glBindVertexArray(0);
+  scvGLStreamFence(&ctx->VertexStream);
+  scvGLStreamFence(&ctx->IndexStream);
+  scvGLStreamFence(&ctx->QuadStream);
+
+  // everything is drawn, keep only state of the last submitted drawcall so
+  // drawing after mid frame flush continues with the same texture
+  last.start = 0;
+  last.len   = 0;
+  scvGLBoundsClear(&last);
+  *scvArrayGet(&ctx->Drawcalls, SCVDrawCall, 0) = last;
+  ctx->Drawcalls.len  = 1;
   ctx->Vertexes.index = 0;
   ctx->Indicies.len   = 0;
+  ctx->Quads.len      = 0;
+  scvZoneEnd();
 }
 
 void
@@ -716,7 +1500,6 @@ scvGLLoadTexture(SCVImage image)
   if (glInternalFormat != 0) {
     for (i = 0; i < mipmapcount; ++i) {
       mipSize = scvGetPixelDataSize(mipWidth, mipHeight, format);
-      glGenerateMipmap(GL_TEXTURE_2D);
       glTexImage2D(GL_TEXTURE_2D, i, glInternalFormat, mipWidth, mipHeight, 0, glFormat, glType, data);
       if (format == SCV_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE) {
         swizzlemap[0] = GL_RED;
@@ -772,7 +1555,7 @@ scvImage(SCVArena *arena, u32 width, u32 height)
   result.pitch = 4 * width;
   result.mipmapcount = 1;
   result.pixelformat = SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
-  result.data = scvArenaAllocErr(arena, result.pitch * height, &error);
+  result.data = scvArenaAllocAlignNoZero(arena, result.pitch * height, &error, SCV_DEFAULT_ALIGNMENT);
   if (error.tag) {
     scvFatalError("can't alloc memory", &error);
   }
@@ -783,157 +1566,564 @@ scvImage(SCVArena *arena, u32 width, u32 height)
   return result;
 }
 
-SCVTexture*
+SCVHandle
 scvLoadTexture(SCVGLCtx *ctx, SCVImage image)
 {
-  SCVTexture* tex = (SCVTexture *)scvPoolAlloc(&ctx->Textures);
+  SCVTexture *tex;
+  SCVHandle handle = scvSlabPoolAlloc(&ctx->Textures, (void **)&tex);
  
   tex->glTexID = scvGLLoadTexture(image);
   tex->width = image.width;
   tex->height = image.height;
   tex->pitch = image.pitch;
 
-  return tex;
+  return handle;
 }
 
-#define JA 1103 // я
-#define CA 1040 // А - cyrillic 
-#define CPLEN (95 + JA - CA)
+// nil when texture was unloaded
+SCVTexture*
+scvGetTexture(SCVGLCtx *ctx, SCVHandle handle)
+{
+  return (SCVTexture *)scvSlabPoolGet(&ctx->Textures, handle);
+}
 
+void
+scvUnloadTexture(SCVGLCtx *ctx, SCVHandle handle)
+{
+  SCVTexture *tex = scvGetTexture(ctx, handle);
 
-typedef struct SCVFontDesc SCVFontDesc;
-struct SCVFontDesc {
-  f32       fontsize;
-  SCVString fontpath; 
-};
+  if (tex) {
+    glDeleteTextures(1, &tex->glTexID);
+    scvSlabPoolFree(&ctx->Textures, handle);
+  }
+}
 
-i32 codepointsbuffer[CPLEN];
+// texture atlas
 
-SCVFont*
-scvFontInit(SCVGLCtx *ctx, SCVArena *arena, SCVFontDesc *desc)
+SCVAtlasPage *
+scvAtlasNewPage(SCVAtlas *atlas)
 {
-  SCVFont *font;
-  f32 fontSize = desc->fontsize;
-  stbtt_fontinfo fontInfo = {0};
-  SCVError error = {0};
-  SCVSlice fontData = scvLoadFile(desc->fontpath, &error);
-  scvAssert(error.tag == 0);
+  SCVAtlasPage *page = &atlas->pages[atlas->pagesLen++];
+  u32 prevTag = scvArenaSetTag(atlas->arena, SCV_MEM_TAG_TEXTURES);
 
-  font = scvPoolAlloc(&ctx->Fonts);
+  page->shelves = scvMakeArray(atlas->arena, SCVAtlasShelf, 32);
+  page->entries = scvMakeArray(atlas->arena, SCVHandle, 256);
+  scvArenaSetTag(atlas->arena, prevTag);
 
-  SCVSlice codepoints = scvUnsafeSlice(codepointsbuffer, CPLEN);
+  return page;
+}
 
-  // TODO(sichirc): figure out is it need to delete font, and if we need to do it
-  // need to know how to allocate glyphs and release them.
-  font->glyphs = scvMakeSlice(arena, SCVGlyph, codepoints.len, codepoints.len);
-  SCVGlyph *glyphs = (SCVGlyph *)font->glyphs.base;
+// (re)creates page texture when it has none or holds the other format
+void
+scvAtlasPageTexture(SCVGLCtx *ctx, SCVAtlasPage *page, bool glyphs)
+{
+  GLint swizzle[4] = {GL_RED, GL_RED, GL_RED, GL_RED};
+  SCVDrawCall *drawcall;
+  u32 size = ctx->Atlas.size;
+  u64 i;
 
-  for (u64 i = 0; i < codepoints.len; ++i) {
-    ((rune *)codepoints.base)[i] = (i < 95) ? (i32)i + 32 : (i32)i + CA - 95;
+  if (page->glTexID && page->glyphs == glyphs) {
+    return;
+  }
+  if (page->glTexID) {
+    // page was flushed before eviction, only kept state may still name it
+    for (i = 0; i < ctx->Drawcalls.len; ++i) {
+      drawcall = scvArrayGet(&ctx->Drawcalls, SCVDrawCall, i);
+      drawcall->texID      = drawcall->texID == page->glTexID ? ctx->DefaultTextureId : drawcall->texID;
+      drawcall->glyphTexID = drawcall->glyphTexID == page->glTexID ? 0 : drawcall->glyphTexID;
+    }
+    glDeleteTextures(1, &page->glTexID);
+  }
+  page->glyphs = glyphs;
+  if (glyphs && !page->shadow) {
+    u32 prevTag = scvArenaSetTag(ctx->Atlas.arena, SCV_MEM_TAG_TEXTURES);
+    page->shadow = scvArenaAlloc(ctx->Atlas.arena, (u64)size * size);
+    scvArenaSetTag(ctx->Atlas.arena, prevTag);
+    scvAssert(page->shadow);
   }
 
-  stbtt_InitFont(&fontInfo, (unsigned char *)fontData.base, 0);
-  f32 scale = stbtt_ScaleForPixelHeight(&fontInfo, fontSize);
+  glGenTextures(1, &page->glTexID);
+  glBindTexture(GL_TEXTURE_2D, page->glTexID);
+  if (glyphs) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, nil);
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+  } else {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nil);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// places w x h (padding included), false when page has no room
+bool
+scvAtlasPack(SCVAtlas *atlas, SCVAtlasPage *page, u32 w, u32 h, u32 *x, u32 *y)
+{
+  SCVAtlasShelf *shelf, *best = nil;
+  u64 i;
+
+  for (i = 0; i < page->shelves.len; ++i) {
+    shelf = scvArrayGet(&page->shelves, SCVAtlasShelf, i);
+    // shelf up to twice taller is fine, the least waste wins
+    if (shelf->height >= h && shelf->height <= h * 2 && atlas->size - shelf->x >= w &&
+        (!best || shelf->height < best->height)) {
+      best = shelf;
+    }
+  }
+
+  if (!best) {
+    if (atlas->size - page->top < h || atlas->size < w) {
+      return false;
+    }
+    best = (SCVAtlasShelf *)scvArrayPushN(&page->shelves, 1);
+    best->y      = page->top;
+    best->height = h;
+    best->x      = 0;
+    page->top   += h;
+  }
 
-  stbtt_GetFontVMetrics(&fontInfo, &font->ascent, &font->descent, &font->linegap);
-  font->scale = scale;
-  font->size = desc->fontsize;
+  *x = best->x;
+  *y = best->y;
+  best->x += w;
 
-  i32 width = 0;
-  i32 height = 0;
-  rune *cp = (rune *)codepoints.base;
-  i32 x1, x2, y1, y2;
-  i32 padding = 2;
-
-  for (u64 i = 0; i < codepoints.len; ++i) {
-    stbtt_GetCodepointBitmapBox(&fontInfo, cp[i], scale, scale, &x1, &y1, &x2, &y2);
-    glyphs[i].width = (x2 - x1);
-    glyphs[i].height = (y2 - y1);
-    width += (glyphs[i].width + padding);
-    height = scvMax(height, glyphs[i].height);
-    stbtt_GetCodepointHMetrics(&fontInfo, cp[i], &glyphs[i].xadvance, &glyphs[i].lsb);
-    glyphs[i].xadvance = (i32)(scale * (f32)glyphs[i].xadvance);
-  }
-
-  height += padding;
-
-
-  // packing 
-  // NOTE(sichirc): for know simplest packing just in one very wide texture
-  // where width is sum of glyphs width and height is height of tallest glyphs
-  SCVImage bitmapImage = scvImage(arena, (u32)width, (u32)height);
-  SCVGlyph *g; 
-  u32 offset = 0;
-  i32 tx = 0;
-  i32 ty = 0;
-
-  for (u64 i = 0; i < codepoints.len; ++i) {
-    rune cp = ((rune *)codepoints.base)[i];
-    g = glyphs + i;
-    g->tx = tx;
-    g->ty = ty;
-    g->codepoint = cp;
-    u8 *bitmap = (u8 *)stbtt_GetCodepointBitmap(
-        &fontInfo,
-        scale,
-        scale,
-        cp,
-        nil,
-        nil,
-        &g->xoffset,
-        &g->yoffset
-    );
-    u8 *source = bitmap; 
-    byte *destRow = (byte *)bitmapImage.data + offset;
-    for (i32 y = 0; y < g->height; ++y) {
-      u32 *dest = (u32 *)destRow;
-      for (i32 x = 0; x < g->width; ++x) {
-        u8 alpha = *source++; 
-        *dest++ = ((alpha << 24) | (alpha << 16) | (alpha << 8) | (alpha << 0));
+  return true;
+}
+
+// copies grayscale image with transparent padding to glyph page shadow at
+// x, y, texture gets it with the next scvAtlasCommit
+void
+scvAtlasShadowWrite(SCVAtlas *atlas, SCVAtlasPage *page, u32 x, u32 y, SCVImage image)
+{
+  u32 pad = SCV_ATLAS_PADDING;
+  u32 w = image.width + 2 * pad, h = image.height + 2 * pad;
+  u32 pitch = image.pitch ? image.pitch : image.width;
+  u8 *dst;
+  u32 row;
+
+  scvAssert(image.pixelformat == SCV_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE);
+  for (row = 0; row < h; ++row) {
+    dst = page->shadow + (u64)(y + row) * atlas->size + x;
+    memset(dst, 0, w);
+    if (row >= pad && row < h - pad) {
+      memcpy(dst + pad, (u8 *)image.data + (row - pad) * pitch, image.width);
+    }
+  }
+
+  if (page->dirty[0] >= page->dirty[2]) {
+    page->dirty[0] = x;
+    page->dirty[1] = y;
+    page->dirty[2] = x + w;
+    page->dirty[3] = y + h;
+  } else {
+    page->dirty[0] = scvMin(page->dirty[0], x);
+    page->dirty[1] = scvMin(page->dirty[1], y);
+    page->dirty[2] = scvMax(page->dirty[2], x + w);
+    page->dirty[3] = scvMax(page->dirty[3], y + h);
+  }
+}
+
+// uploads changed part of every glyph page shadow, one texture update per
+// page however many glyphs were added
+void
+scvAtlasCommit(SCVGLCtx *ctx)
+{
+  SCVAtlas *atlas = &ctx->Atlas;
+  SCVAtlasPage *page;
+  u32 i, w, h;
+
+  for (i = 0; i < atlas->pagesLen; ++i) {
+    page = &atlas->pages[i];
+    if (!page->glyphs || page->dirty[0] >= page->dirty[2]) {
+      continue;
+    }
+    w = page->dirty[2] - page->dirty[0];
+    h = page->dirty[3] - page->dirty[1];
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, atlas->size);
+    glBindTexture(GL_TEXTURE_2D, page->glTexID);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, page->dirty[0], page->dirty[1], w, h, GL_RED, GL_UNSIGNED_BYTE,
+        page->shadow + (u64)page->dirty[1] * atlas->size + page->dirty[0]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    ctx->Stats.atlasUploads++;
+    ctx->Stats.atlasBytes += (u64)w * h;
+    page->dirty[0] = page->dirty[2] = 0;
+  }
+}
+
+// uploads image with transparent padding at x, y, converted to RGBA. Glyph
+// pages take grayscale as is, through shadow.
+void
+scvAtlasUpload(SCVGLCtx *ctx, SCVAtlasPage *page, u32 x, u32 y, SCVImage image)
+{
+  SCVArenaTemp scratch;
+  u32 pad = SCV_ATLAS_PADDING;
+  SCVImage padded;
+  u8 *src, *dst;
+  u32 row, col, pitch;
+
+  if (page->glyphs) {
+    scvAtlasShadowWrite(&ctx->Atlas, page, x, y, image);
+    return;
+  }
+
+  scratch = scvScratchBegin(nil, 0);
+  padded  = scvImage(scratch.arena, image.width + 2 * pad, image.height + 2 * pad);
+
+  switch (image.pixelformat) {
+  case SCV_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:      pitch = image.width;     break;
+  case SCV_PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA:     pitch = image.width * 2; break;
+  case SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8:         pitch = image.width * 3; break;
+  default:                                          pitch = image.width * 4; break;
+  }
+  pitch = image.pitch ? image.pitch : pitch;
+
+  for (row = 0; row < image.height; ++row) {
+    src = (u8 *)image.data + row * pitch;
+    dst = (u8 *)padded.data + (row + pad) * padded.pitch + pad * 4;
+    for (col = 0; col < image.width; ++col, dst += 4) {
+      switch (image.pixelformat) {
+      case SCV_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:
+        dst[0] = dst[1] = dst[2] = *src++;
+        dst[3] = 255;
+        break;
+      case SCV_PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA:
+        dst[0] = dst[1] = dst[2] = *src++;
+        dst[3] = *src++;
+        break;
+      case SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8:
+        dst[0] = *src++;
+        dst[1] = *src++;
+        dst[2] = *src++;
+        dst[3] = 255;
+        break;
+      default:
+        memcpy(dst, src, 4);
+        src += 4;
+        break;
       }
-      destRow += bitmapImage.pitch;
-    } 
-    offset += (g->width * 4 + padding * 4);
-    stbtt_FreeBitmap(bitmap, nil);
-    tx += (g->width + padding);
+    }
   }
 
-  font->texture = scvLoadTexture(ctx, bitmapImage);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glBindTexture(GL_TEXTURE_2D, page->glTexID);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, padded.width, padded.height, GL_RGBA, GL_UNSIGNED_BYTE, padded.data);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  ctx->Stats.atlasUploads++;
+  ctx->Stats.atlasBytes += padded.pitch * padded.height;
+  scvScratchEnd(scratch);
+}
 
-  scvUnloadFile(fontData);
+// page starts over as image or glyph page: entries are freed, white block
+// goes in first
+void
+scvAtlasResetPage(SCVGLCtx *ctx, SCVAtlasPage *page, bool glyphs)
+{
+  SCVAtlas *atlas = &ctx->Atlas;
+  u8 white[SCV_ATLAS_WHITE * SCV_ATLAS_WHITE * 4];
+  SCVImage image = {0};
+  u64 i;
+  u32 x, y;
 
-  return font;
+  for (i = 0; i < page->entries.len; ++i) {
+    scvSlabPoolFree(&atlas->entries, *scvArrayGet(&page->entries, SCVHandle, i));
+  }
+  if (page->glyphs && page->entries.len) {
+    ctx->Stats.glyphEvictions += page->entries.len;
+  }
+  scvArrayClear(&page->entries);
+  scvArrayClear(&page->shelves);
+  page->top = 0;
+  page->pinned = 0;
+  page->dirty[0] = page->dirty[2] = 0;
+  scvAtlasPageTexture(ctx, page, glyphs);
+
+  memset(white, 255, sizeof(white));
+  image.data = white;
+  image.width = image.height = SCV_ATLAS_WHITE;
+  image.pixelformat = glyphs ? SCV_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE : SCV_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+  scvAtlasPack(atlas, page, SCV_ATLAS_WHITE + 2 * SCV_ATLAS_PADDING, SCV_ATLAS_WHITE + 2 * SCV_ATLAS_PADDING, &x, &y);
+  scvAtlasUpload(ctx, page, x, y, image);
 }
 
-u64
-scvFindGlyph(SCVFont *font, rune codepoint)
+// page of the kind with room for w x h, new one or least recently used
+// of any kind dropped, nil when every page is pinned
+SCVAtlasPage *
+scvAtlasFindPage(SCVGLCtx *ctx, bool glyphs, u32 w, u32 h, u32 *x, u32 *y)
 {
-  u64 result = 0;
-  SCVGlyph* glyphs = (SCVGlyph *)font->glyphs.base;
-  for (u64 i = 0; i < font->glyphs.len; ++i) {
-    if (glyphs[i].codepoint == codepoint) {
-      result = i;
-      break;
+  SCVAtlas *atlas = &ctx->Atlas;
+  SCVAtlasPage *page, *lru = nil;
+  u32 i;
+
+  for (i = 0; i < atlas->pagesLen; ++i) {
+    page = &atlas->pages[i];
+    if (page->glyphs == glyphs && scvAtlasPack(atlas, page, w, h, x, y)) {
+      return page;
+    }
+    if (page->pinned == 0 && (!lru || page->lastUsed < lru->lastUsed)) {
+      lru = page;
     }
   }
 
-  return result;
+  if (atlas->pagesLen < atlas->maxPages) {
+    page = scvAtlasNewPage(atlas);
+  } else if (lru) {
+    if (lru->lastUsed == atlas->frame) {
+      // already recorded draws have to sample old contents
+      scvGLFlush(ctx);
+    }
+    page = lru;
+    atlas->evictions++;
+  } else {
+    return nil;
+  }
+
+  scvAtlasResetPage(ctx, page, glyphs);
+  if (!scvAtlasPack(atlas, page, w, h, x, y)) {
+    return nil;
+  }
+
+  return page;
+}
+
+// copies image into atlas, SCV_HANDLE_NIL when it is bigger than page or
+// everything is pinned. Flags are SCVAtlasFlags, pinned entry lives as
+// long as atlas.
+SCVHandle
+scvAtlasAdd(SCVGLCtx *ctx, SCVImage image, u32 flags)
+{
+  SCVAtlas *atlas = &ctx->Atlas;
+  SCVAtlasPage *page;
+  SCVAtlasEntry *entry;
+  SCVHandle handle;
+  u32 x, y;
+
+  page = scvAtlasFindPage(ctx, (flags & SCV_ATLAS_GLYPH) != 0, image.width + 2 * SCV_ATLAS_PADDING, image.height + 2 * SCV_ATLAS_PADDING, &x, &y);
+  if (!page) {
+    scvWarn("ATLAS", "no room in atlas");
+    return SCV_HANDLE_NIL;
+  }
+  scvAtlasUpload(ctx, page, x, y, image);
+
+  handle = scvSlabPoolAlloc(&atlas->entries, (void **)&entry);
+  entry->page   = (u32)(page - atlas->pages);
+  entry->x      = x + SCV_ATLAS_PADDING;
+  entry->y      = y + SCV_ATLAS_PADDING;
+  entry->width  = image.width;
+  entry->height = image.height;
+  scvArrayPush(&page->entries, SCVHandle, handle);
+  page->pinned  += (flags & SCV_ATLAS_PINNED) ? 1 : 0;
+  page->lastUsed = atlas->frame;
+  atlas->adds++;
+
+  return handle;
+}
+
+// nil when entry was dropped with its page
+SCVAtlasEntry *
+scvAtlasGet(SCVGLCtx *ctx, SCVHandle handle)
+{
+  return (SCVAtlasEntry *)scvSlabPoolGet(&ctx->Atlas.entries, handle);
+}
+
+// makes entry page current texture and marks it used in this frame,
+// returns SCVGLQuadFlags to draw it with. Quads take glyph page as second
+// texture, vertices only have the first one.
+u32
+scvAtlasUse(SCVGLCtx *ctx, SCVAtlasEntry *entry, SCVUVRect *uv)
+{
+  SCVAtlas *atlas = &ctx->Atlas;
+  SCVAtlasPage *page = &atlas->pages[entry->page];
+  f32 size = (f32)atlas->size;
+  u32 flags = 0;
+
+  page->lastUsed = atlas->frame;
+  if (page->glyphs && ctx->QuadMode == SCV_GL_QUAD_INSTANCED) {
+    scvGLUseDrawCall(ctx, SCV_DRAW_QUADS, 0, page->glTexID);
+    flags = SCV_QUAD_GLYPH;
+  } else {
+    scvGLUseDrawCall(ctx, scvGLRectKind(ctx), page->glTexID, 0);
+  }
+
+  uv->topleft[0]     = (f32)entry->x / size;
+  uv->topleft[1]     = (f32)entry->y / size;
+  uv->topright[0]    = (f32)(entry->x + entry->width) / size;
+  uv->topright[1]    = (f32)entry->y / size;
+  uv->bottomleft[0]  = (f32)entry->x / size;
+  uv->bottomleft[1]  = (f32)(entry->y + entry->height) / size;
+  uv->bottomright[0] = (f32)(entry->x + entry->width) / size;
+  uv->bottomright[1] = (f32)(entry->y + entry->height) / size;
+
+  return flags;
+}
+
+// false when entry was dropped, owner adds image again then
+bool
+scvGLDrawAtlasImage(SCVGLCtx *ctx, SCVRect rect, SCVColor color, SCVHandle handle)
+{
+  SCVAtlasEntry *entry = scvAtlasGet(ctx, handle);
+  SCVUVRect uv;
+  u32 flags;
+
+  if (!entry) {
+    return false;
+  }
+  flags = scvAtlasUse(ctx, entry, &uv);
+  scvGLDrawRectInternal(ctx, rect, color, &uv, flags);
+
+  return true;
+}
+
+SCVFont*
+scvGetFont(SCVGLCtx *ctx, SCVHandle handle)
+{
+  return (SCVFont *)scvSlabPoolGet(&ctx->Fonts, handle);
+}
+
+typedef struct SCVFontDesc SCVFontDesc;
+struct SCVFontDesc {
+  f32       fontsize;
+  SCVString fontpath; 
+  SCVString fontdata; // already loaded file, copied so caller can drop it
+};
+
+// unmaps font file, glyphs in atlas go with their pages. Copy of font data
+// and glyph arrays stay in arena font was made with.
+void
+scvUnloadFont(SCVGLCtx *ctx, SCVHandle handle)
+{
+  SCVFont *font = scvGetFont(ctx, handle);
+
+  if (!font) {
+    return;
+  }
+  if (font->mapped) {
+    scvUnmapFile(&font->file);
+  }
+  scvSlabPoolFree(&ctx->Fonts, handle);
+}
+
+// glyphs are rasterized on first use, not here
+SCVHandle
+scvFontInit(SCVGLCtx *ctx, SCVArena *arena, SCVFontDesc *desc)
+{
+  SCVFont *font;
+  SCVHandle handle;
+  SCVError error = {0};
+  u32 prevTag;
+  scvZoneBegin("scvFontInit");
+
+  handle = scvSlabPoolAlloc(&ctx->Fonts, (void **)&font);
+
+  // rasterizer reads font file on every miss, it lives as long as font
+  prevTag = scvArenaSetTag(arena, SCV_MEM_TAG_FONTS);
+  if (desc->fontdata.len) {
+    font->file.base = scvArenaAllocNoZero(arena, desc->fontdata.len);
+    scvAssert(font->file.base);
+    memcpy(font->file.base, desc->fontdata.base, desc->fontdata.len);
+    font->file.len = desc->fontdata.len;
+  } else {
+    // stbtt jumps all over the tables, fault whole font in at once
+    font->file = scvMapFile(desc->fontpath, &((SCVFileMapDesc){
+      .access = SCV_FILE_ACCESS_RANDOM,
+      .populate = true,
+    }), &error);
+    font->mapped = error.tag == 0;
+  }
+  scvArenaSetTag(arena, SCV_MEM_TAG_GLYPHS);
+  font->glyphs = scvMakeArray(arena, SCVGlyph, 256);
+  scvMapInit(&font->glyphIndex, arena, 256, false);
+  scvArenaSetTag(arena, prevTag);
+
+  if (error.tag || !stbtt_InitFont(&font->info, font->file.base, 0)) {
+    scvWarn("FONT", "can't read font");
+    scvUnloadFont(ctx, handle);
+    scvZoneEnd();
+    return SCV_HANDLE_NIL;
+  }
+  font->scale = stbtt_ScaleForPixelHeight(&font->info, desc->fontsize);
+  font->size  = desc->fontsize;
+  stbtt_GetFontVMetrics(&font->info, &font->ascent, &font->descent, &font->linegap);
+  scvZoneEnd();
+
+  return handle;
+}
+
+// glyph of codepoint, metrics are read from font the first time it is
+// asked for. Codepoint font doesn't have gets its missing glyph box.
+// Pointer is good until next new glyph of the font.
+SCVGlyph *
+scvFindGlyph(SCVFont *font, rune codepoint)
+{
+  u64 *index = scvMapGetU64(&font->glyphIndex, (u64)codepoint);
+  SCVGlyph *g;
+  i32 x0, y0, x1, y1;
+
+  if (index) {
+    return scvArrayGet(&font->glyphs, SCVGlyph, *index);
+  }
+
+  scvMapPutU64(&font->glyphIndex, (u64)codepoint, font->glyphs.len);
+  g = (SCVGlyph *)scvArrayPushN(&font->glyphs, 1);
+  g->codepoint = codepoint;
+  g->index     = stbtt_FindGlyphIndex(&font->info, codepoint);
+  stbtt_GetGlyphHMetrics(&font->info, g->index, &g->xadvance, &g->lsb);
+  g->xadvance  = (i32)(font->scale * (f32)g->xadvance);
+  stbtt_GetGlyphBitmapBox(&font->info, g->index, font->scale, font->scale, &x0, &y0, &x1, &y1);
+  g->width     = x1 - x0;
+  g->height    = y1 - y0;
+  g->xoffset   = x0;
+  g->yoffset   = y0;
+  g->entry     = SCV_HANDLE_NIL;
+
+  return g;
+}
+
+// atlas entry with glyph bitmap, nil for empty glyphs (space). Bitmap is
+// rasterized on first draw and again after its page was dropped, it gets
+// to texture with the next flush.
+SCVAtlasEntry *
+scvFontGlyphEntry(SCVGLCtx *ctx, SCVFont *font, SCVGlyph *glyph)
+{
+  SCVAtlasEntry *entry;
+  SCVImage image = {0};
+  i32 width, height;
+
+  if (glyph->width <= 0 || glyph->height <= 0) {
+    return nil;
+  }
+  entry = scvAtlasGet(ctx, glyph->entry);
+  if (entry) {
+    ctx->Stats.glyphHits++;
+    return entry;
+  }
+
+  ctx->Stats.glyphMisses++;
+  image.data = stbtt_GetGlyphBitmap(&font->info, font->scale, font->scale, glyph->index,
+      &width, &height, nil, nil);
+  if (!image.data) {
+    return nil;
+  }
+  image.width       = (u32)width;
+  image.height      = (u32)height;
+  image.pitch       = image.width;
+  image.mipmapcount = 1;
+  image.pixelformat = SCV_PIXELFORMAT_UNCOMPRESSED_GRAYSCALE;
+  glyph->entry = scvAtlasAdd(ctx, image, SCV_ATLAS_GLYPH);
+  stbtt_FreeBitmap(image.data, nil);
+
+  return scvAtlasGet(ctx, glyph->entry);
 }
 
 void
 scvBindTexture(SCVGLCtx *ctx, SCVTexture *texture)
 {
-  SCVDrawCall drawcall = {0};
   scvAssert(ctx);
   scvAssert(texture);
-  SCVDrawCall currentDrawCall = ((SCVDrawCall *)ctx->Drawcalls.base)[ctx->Drawcalls.len - 1];
-  if (currentDrawCall.texID != texture->glTexID) {
-    drawcall.start = ctx->Indicies.len;
-    drawcall.len   = 0;
-    drawcall.shaderID = ctx->DefaultShader;
-    drawcall.texID = texture->glTexID;
-    scvSliceAppend(ctx->Drawcalls, drawcall);
-  }
+  scvGLUseDrawCall(ctx, scvGLRectKind(ctx), texture->glTexID, 0);
 }
 
 SCVSize
@@ -941,22 +2131,24 @@ scvMeasureText(SCVFont *font, SCVString text)
 {
   SCVSize size = {0};
   SCVGlyph *glyph = nil;
-  i32 glyphIndex = 0;
-  rune r = 0;
+  rune *runes;
+  u64 i;
   SCVError error = {0};
-  SCVUTF8Iterator iterator = scvUTF8Iterator(text);
+  SCVArenaTemp scratch = scvScratchBegin(nil, 0);
+  SCVSlice runesSlice = scvUTF8DecodeToSlice(scratch.arena, text, &error);
+
+  if (error.tag) {
+    scvFatalError("not valid utf8", &error);
+  }
 
   size.height = font->size;
-  while (scvUTF8HasNext(&iterator)) {
-    r = scvUTF8GetNext(&iterator, &error);
-    if (error.tag) {
-      scvFatalError("not valid utf8", &error);
-    }
-    glyphIndex = scvFindGlyph(font, r);
-    glyph = (SCVGlyph *)font->glyphs.base + glyphIndex;
+  runes = (rune *)runesSlice.base;
+  for (i = 0; i < runesSlice.len; ++i) {
+    glyph = scvFindGlyph(font, runes[i]);
     size.width += ((f32)glyph->xoffset + (f32)glyph->width);
   }
 
+  scvScratchEnd(scratch);
   return size;
 }
 
@@ -968,55 +2160,45 @@ scvDrawText(SCVGLCtx *ctx, SCVColor color, SCVFont *font, SCVPoint origin, SCVSt
 {
 
   SCVGlyph *glyph;
-  SCVTexture *texture;
-  u64 glyphIndex = 0;
+  SCVAtlasEntry *entry;
+  u32 flags;
   f32 baseline = 0.0f;
-  rune r = 0;
+  rune *runes;
+  u64 i;
   SCVError error = {0};
-  SCVUTF8Iterator iterator = scvUTF8Iterator(text);
+  SCVArenaTemp scratch = scvScratchBegin(nil, 0);
+  SCVSlice runesSlice = scvUTF8DecodeToSlice(scratch.arena, text, &error);
   SCVRect rect = {0};
   SCVUVRect uvrect = {0};
 
-  texture = font->texture;
   rect.origin = origin;
 
   baseline = origin.y + (f32)font->ascent * (f32)font->scale;
 
-  scvBindTexture(ctx, texture);
-
-  while (scvUTF8HasNext(&iterator)) {
-    r = scvUTF8GetNext(&iterator, &error);
-
-    if (error.tag) {
-      scvFatalError("not valid utf8", &error);
-    }
+  if (error.tag) {
+    scvFatalError("not valid utf8", &error);
+  }
 
-    glyphIndex = scvFindGlyph(font, r);
-    glyph = (SCVGlyph *)font->glyphs.base + glyphIndex;
+  runes = (rune *)runesSlice.base;
+  for (i = 0; i < runesSlice.len; ++i) {
+    glyph = scvFindGlyph(font, runes[i]);
     rect.origin.y = roundf(baseline + glyph->yoffset);
 
     rect.size.width = (f32)glyph->width;
     rect.size.height = (f32)glyph->height;
 
-    uvrect.topleft[0] = ((f32)glyph->tx / (f32)texture->width); 
-    uvrect.topleft[1] = ((f32)glyph->ty / (f32)texture->height);
-
-    uvrect.topright[0] = ((f32)(glyph->tx + glyph->width) / (f32)texture->width);
-    uvrect.topright[1] = ((f32)glyph->ty / (f32)texture->height);
-
-    uvrect.bottomleft[0] = ((f32)glyph->tx / (f32)texture->width);
-    uvrect.bottomleft[1] = ((f32)(glyph->ty + glyph->height) / (f32)texture->height);
-
-    uvrect.bottomright[0] = ((f32)(glyph->tx + glyph->width) / (f32)texture->width);
-    uvrect.bottomright[1] = ((f32)glyph->height / (f32)texture->height); 
-
-    scvGLDrawRectInternal(ctx, rect, color, &uvrect);
+    // empty glyphs (space) only advance
+    entry = scvFontGlyphEntry(ctx, font, glyph);
+    if (entry) {
+      flags = scvAtlasUse(ctx, entry, &uvrect);
+      scvGLDrawRectInternal(ctx, rect, color, &uvrect, flags);
+    }
     rect.origin.x += (f32)glyph->xoffset + (f32)glyph->xadvance;
   }
 
+  scvScratchEnd(scratch);
 }
 
-
 /*
 void
 scvFontInit(SCVArena *arena, SCVFont *font, SCVSlice codepoints, SCVError  *error)